@@ -9,25 +9,96 @@
 // ------------------ TFT 디스플레이 객체 생성 ------------------
 TFT_eSPI display = TFT_eSPI();
 
-// ------------------ 초음파 센서 핀 정의 ------------------
-const int trigPin = 43;
-const int echoPin = 44; 
-const int trigPin2 = 18;
-const int echoPin2 = 17;
-
-long duration1 = 0, duration2 = 0;    // 초음파 신호 왕복 시간 변수
-float distance1 = 0, distance2 = 0;   // 센서로부터 측정된 거리(cm)
-int peopleCount = 0;                  // 현재 인원 수
+// ------------------ 초음파 센서 / 출입문 정의 ------------------
+// 센서 하나(HC-SR04)의 핀과 최근 측정 결과
+struct UltrasonicSensor {
+  int trigPin;
+  int echoPin;
+  volatile unsigned long echoStart;  // 에코 상승 시각(us), ISR에서 기록
+  volatile unsigned long echoEnd;    // 에코 하강 시각(us), ISR에서 기록
+  volatile bool echoDone;            // 이번 트리거의 에코 수신 완료 여부
+  float distance;                    // 마지막 측정 거리(cm), 0이면 측정 실패
+  unsigned long samples;             // 누적 측정 횟수 (측정 속도 통계용)
+};
+
+// 출입문 통과 방향 판정 상태
+enum DoorState {
+  DOOR_IDLE,        // 대기
+  DOOR_OUTER_FIRST, // 1번(입구) 센서 먼저 감지 -> 입장 대기
+  DOOR_INNER_FIRST, // 2번(출구) 센서 먼저 감지 -> 퇴장 대기
+  DOOR_WAIT_CLEAR   // 카운트 완료, 두 센서가 비워질 때까지 대기 (중복 카운트 방지)
+};
+
+// 출입문 하나 = 센서 한 쌍
+struct Doorway {
+  const char* name;
+  int zone;                 // 음향 간섭 구역: 같은 구역의 센서는 zoneCycleUs 간격으로 하나씩만 트리거
+  UltrasonicSensor outer;   // 1번 센서(입구 쪽)
+  UltrasonicSensor inner;   // 2번 센서(출구 쪽)
+  DoorState state;
+  unsigned long stateSince; // 현재 상태 진입 시각(ms)
+  int entered;              // 누적 입장 수
+  int exited;               // 누적 퇴장 수
+  int occupancy;            // 이 문으로 들어와 아직 안에 있는 인원
+};
+
+#ifdef SCHEDULER_BENCH
+// 벤치마크 전용 출입문 목록: 센서 없이 에코 타이밍을 시뮬레이션 (핀 미사용)
+// 구역과 에코 길이는 runSchedulerBenchmark에서 시나리오별로 다시 지정
+Doorway doorways[] = {
+  {"bench1", 0, {-1, -1}, {-1, -1}},
+  {"bench2", 0, {-1, -1}, {-1, -1}},
+  {"bench3", 0, {-1, -1}, {-1, -1}},
+  {"bench4", 0, {-1, -1}, {-1, -1}},
+};
+const unsigned long benchEchoDelayUs = 450; // 트리거 후 에코 시작까지 지연(us)
+unsigned long benchEchoPulseUs = 0;         // 시뮬레이션 에코 HIGH 유지 시간(us)
+#else
+// 출입문 목록: {이름, 구역, {입구 trig, echo}, {출구 trig, echo}}
+// 서로 떨어진 문은 다른 구역으로 두면 서로 기다리지 않고 동시에 측정된다.
+Doorway doorways[] = {
+  {"front", 0, {43, 44}, {18, 17}},
+  // {"back", 1, {1, 2}, {3, 10}},
+};
+#endif
+const int doorwayCount = sizeof(doorways) / sizeof(doorways[0]);
+int activeDoorways = doorwayCount;    // 스케줄링 대상 출입문 수 (벤치마크 시 조정)
+
+const int MAX_ZONES = 4;              // 최대 구역 수
+const int MAX_ZONE_SENSORS = 8;       // 구역당 최대 센서 수
+
+// 구역별 트리거 스케줄러 상태 (구역마다 독립적으로 진행)
+struct ZoneSchedule {
+  UltrasonicSensor* sensors[MAX_ZONE_SENSORS]; // 트리거 순서
+  int sensorCount;
+  int next;                    // 다음에 트리거할 센서 인덱스
+  UltrasonicSensor* active;    // 에코를 기다리는 센서 (없으면 NULL)
+  unsigned long triggerMicros; // 마지막 트리거 시각(us)
+};
+ZoneSchedule zones[MAX_ZONES];
+
+// 같은 구역에서 연속 트리거 사이 최소 간격(us), 에코 종료가 아니라 트리거 시점부터 잰다.
+// 첫 에코가 돌아온 뒤에도 먼 반사면의 잔향이 남아 있으므로 HC-SR04 권장 측정 주기(60ms)를 기본값으로 사용
+// (반사면이 가까운 설치 환경에서는 빌드 플래그 -DZONE_CYCLE_US=... 로 조정)
+#ifndef ZONE_CYCLE_US
+#define ZONE_CYCLE_US 60000
+#endif
+unsigned long zoneCycleUs = ZONE_CYCLE_US;
+const unsigned long echoTimeoutUs = 30000;  // 이 시간 안에 돌아오지 않은 에코는 측정 실패(거리 0)로 처리
+
+int peopleCount = 0;                  // 현재 인원 수 (전체 출입문 합계)
 int previousPeopleCount = -1;         // 이전 인원수 (변화 감지용)
 int maxPeopleAllowed = 0;             // 설정된 최대 인원 수
 
 WiFiClient espClient;
 PubSubClient mqttClient(espClient);
 
-unsigned long lastSensorCheck = 0;           // 마지막으로 센서 체크한 시간(ms)
-const unsigned long sensorInterval = 50;     // 초음파 센서 체크 주기(ms)
+unsigned long lastSensorCheck = 0;           // 마지막으로 인원 수 상태를 체크한 시간(ms)
+const unsigned long sensorInterval = 50;     // 인원 수 상태 체크 주기(ms)
 const float distanceThreshold = 50.0;        // 센서 거리 판정 임계값(cm)
-const unsigned long maxStateDuration = 2000; // 상태 유지 최대 시간(ms) (미사용 변수이지만 원문 유지)
+const unsigned long maxStateDuration = 2000; // 방향 판정 상태 유지 최대 시간(ms)
+unsigned long lastStatsTime = 0;             // 마지막 측정 속도 통계 출력 시간
+const unsigned long statsInterval = 10000;   // 측정 속도 통계 출력 간격(ms)
 unsigned long lastWarningBlink = 0;          // 경고 깜빡임 시간 저장 변수
 const unsigned long warningBlinkInterval = 500; // 경고 깜빡임 간격(ms)
 bool warningState = false;                   // 경고 상태 플래그
@@ -51,7 +122,7 @@ const char* mqtt_topic_publish_security_warning = "home/security/command"; // 
 // ------------------ 사람 수 디스플레이 업데이트 함수 ------------------
 void updatePeopleCountOnDisplay() {
   // 디스플레이 특정 영역을 검은색으로 지우고 새 정보 출력
-  display.fillRect(20, 80, 240, 60, TFT_BLACK); 
+  display.fillRect(20, 80, 240, 60 + 10 * doorwayCount, TFT_BLACK);
   display.setCursor(20, 80);
   display.setTextSize(2);
   display.setTextColor(TFT_WHITE, TFT_BLACK);
@@ -60,8 +131,277 @@ void updatePeopleCountOnDisplay() {
   display.setCursor(20, 110);
   display.print("CURRENT : ");
   display.println(peopleCount);
+
+  // 출입문별 재실 인원
+  display.setTextSize(1);
+  for (int i = 0; i < doorwayCount; i++) {
+    display.setCursor(20, 140 + 10 * i);
+    display.printf("%s : %d", doorways[i].name, doorways[i].occupancy);
+  }
+}
+
+// ------------------ 초음파 에코 인터럽트 함수 ------------------
+void IRAM_ATTR onEcho(void* arg) {
+  // 에코 핀 상승/하강 시각을 기록 (pulseIn 대신 사용해 여러 센서를 동시에 측정)
+  UltrasonicSensor* sensor = (UltrasonicSensor*)arg;
+  if (digitalRead(sensor->echoPin) == HIGH) {
+    sensor->echoStart = micros();
+  } else {
+    sensor->echoEnd = micros();
+    sensor->echoDone = true;
+  }
+}
+
+// ------------------ 센서 스케줄 구성 함수 ------------------
+void buildSensorSchedule() {
+  // 구역별로 센서를 나열: 각 구역은 자기 센서를 차례로 하나씩 트리거한다.
+  // 같은 구역 센서는 절대 동시에 울리지 않고, 센서가 적은 구역은 더 자주 측정된다.
+  unsigned long now = micros();
+  for (int z = 0; z < MAX_ZONES; z++) {
+    zones[z].sensorCount = 0;
+    zones[z].next = 0;
+    zones[z].active = NULL;
+    zones[z].triggerMicros = now - zoneCycleUs; // 첫 트리거는 바로 시작
+  }
+  for (int i = 0; i < activeDoorways; i++) {
+    ZoneSchedule& zone = zones[constrain(doorways[i].zone, 0, MAX_ZONES - 1)];
+    if (zone.sensorCount + 2 > MAX_ZONE_SENSORS) {
+      Serial.printf("Zone %d is full, skipping doorway %s\n", doorways[i].zone, doorways[i].name);
+      continue;
+    }
+    zone.sensors[zone.sensorCount++] = &doorways[i].outer;
+    zone.sensors[zone.sensorCount++] = &doorways[i].inner;
+  }
+}
+
+// ------------------ 센서 트리거 함수 ------------------
+bool isEchoHigh(const UltrasonicSensor* sensor, unsigned long now) {
+#ifdef SCHEDULER_BENCH
+  return (long)(now - sensor->echoStart) >= 0 && (long)(now - sensor->echoEnd) < 0;
+#else
+  return digitalRead(sensor->echoPin) == HIGH;
+#endif
+}
+
+void triggerSensor(UltrasonicSensor* sensor) {
+  sensor->echoDone = false;
+#ifdef SCHEDULER_BENCH
+  // 시뮬레이션: 트리거 후 benchEchoDelayUs 뒤 에코 시작, benchEchoPulseUs 동안 HIGH 유지
+  sensor->echoStart = micros() + benchEchoDelayUs;
+  sensor->echoEnd = sensor->echoStart + benchEchoPulseUs;
+#else
+  digitalWrite(sensor->trigPin, LOW);
+  delayMicroseconds(2);
+  digitalWrite(sensor->trigPin, HIGH);
+  delayMicroseconds(10);
+  digitalWrite(sensor->trigPin, LOW);
+#endif
+}
+
+// ------------------ 구역 스케줄 진행 함수 ------------------
+// 측정이 끝난 센서가 있으면 true 반환
+bool serviceSensors() {
+  bool measured = false;
+  unsigned long now = micros();
+
+  for (int z = 0; z < MAX_ZONES; z++) {
+    ZoneSchedule& zone = zones[z];
+    if (zone.sensorCount == 0) continue;
+
+    if (zone.active != NULL) {
+      UltrasonicSensor* sensor = zone.active;
+#ifdef SCHEDULER_BENCH
+      // 시뮬레이션: 에코 하강 시각이 지나면 ISR 대신 수신 완료 처리
+      if ((long)(now - sensor->echoEnd) >= 0) sensor->echoDone = true;
+#endif
+      if (!sensor->echoDone && now - zone.triggerMicros < echoTimeoutUs) continue;
+      sensor->distance = sensor->echoDone ? (sensor->echoEnd - sensor->echoStart) * 0.017 : 0;
+      sensor->samples++;
+      zone.active = NULL;
+      measured = true;
+    }
+
+    // 에코가 빨리 돌아와도 트리거 후 zoneCycleUs가 지나야 같은 구역의 다음 센서를 트리거
+    if (now - zone.triggerMicros < zoneCycleUs) continue;
+    UltrasonicSensor* sensor = zone.sensors[zone.next];
+    // 무반사 타임아웃으로 에코가 아직 HIGH면 내려갈 때까지 대기
+    if (isEchoHigh(sensor, now)) continue;
+    triggerSensor(sensor);
+    zone.active = sensor;
+    zone.triggerMicros = micros();
+    zone.next = (zone.next + 1) % zone.sensorCount;
+  }
+  return measured;
+}
+
+// ------------------ 출입문 방향 판정 함수 ------------------
+bool isNear(const UltrasonicSensor& sensor) {
+  return sensor.distance > 0 && sensor.distance < distanceThreshold;
+}
+
+// 퇴장 반영: 이 문으로 들어온 사람이 있으면 이 문에서, 없으면 인원이 가장 많은 문에서 1명 차감
+// 안에 아무도 없으면 오검출로 보고 무시 (인원 수 음수 방지)
+bool countExit(Doorway& door) {
+  Doorway* from = &door;
+  if (from->occupancy == 0) {
+    for (int i = 0; i < doorwayCount; i++) {
+      if (doorways[i].occupancy > from->occupancy) from = &doorways[i];
+    }
+  }
+  if (from->occupancy == 0) return false;
+  from->occupancy--;
+  door.exited++;
+  return true;
+}
+
+void updateDoorway(Doorway& door, unsigned long currentMillis) {
+  bool outerNear = isNear(door.outer);
+  bool innerNear = isNear(door.inner);
+
+  switch (door.state) {
+    case DOOR_IDLE:
+      if (outerNear && !innerNear) {
+        door.state = DOOR_OUTER_FIRST;
+        door.stateSince = currentMillis;
+      } else if (innerNear && !outerNear) {
+        door.state = DOOR_INNER_FIRST;
+        door.stateSince = currentMillis;
+      }
+      break;
+
+    case DOOR_OUTER_FIRST:
+      // 사람이 1번 센서 -> 2번 센서 방향으로 이동한 경우(입장)
+      if (innerNear) {
+        Serial.printf("[%s] 1번 -> 2번으로 이동: 사람 들어옴\n", door.name);
+        door.entered++;
+        door.occupancy++;
+        door.state = DOOR_WAIT_CLEAR;
+        door.stateSince = currentMillis;
+      } else if (currentMillis - door.stateSince >= maxStateDuration) {
+        door.state = DOOR_IDLE;
+      }
+      break;
+
+    case DOOR_INNER_FIRST:
+      // 사람이 2번 센서 -> 1번 센서 방향으로 이동한 경우(퇴장)
+      if (outerNear) {
+        if (countExit(door)) {
+          Serial.printf("[%s] 2번 -> 1번으로 이동: 사람 나감\n", door.name);
+        } else {
+          Serial.printf("[%s] 퇴장 감지 무시: 재실 인원 없음\n", door.name);
+        }
+        door.state = DOOR_WAIT_CLEAR;
+        door.stateSince = currentMillis;
+      } else if (currentMillis - door.stateSince >= maxStateDuration) {
+        door.state = DOOR_IDLE;
+      }
+      break;
+
+    case DOOR_WAIT_CLEAR:
+      if ((!outerNear && !innerNear) || currentMillis - door.stateSince >= maxStateDuration) {
+        door.state = DOOR_IDLE;
+      }
+      break;
+  }
+}
+
+// ------------------ 인원 수 합산 함수 ------------------
+void updatePeopleCount() {
+  int total = 0;
+  for (int i = 0; i < doorwayCount; i++) {
+    total += doorways[i].occupancy;
+  }
+  if (total != peopleCount) {
+    peopleCount = total;
+    updatePeopleCountOnDisplay();
+  }
+}
+
+// ------------------ 인원 수 상태 발행 함수 ------------------
+// 문 목록 길이가 출입문 수에 따라 달라지므로 버퍼 없이 스트리밍 발행, 실패 시 false
+bool publishSecurityStatus() {
+  JsonDocument jsonDoc;
+  jsonDoc["people_count"] = peopleCount;
+  jsonDoc["max_people_allowed"] = maxPeopleAllowed;
+  JsonArray doors = jsonDoc["doors"].to<JsonArray>();
+  for (int i = 0; i < doorwayCount; i++) {
+    JsonObject door = doors.add<JsonObject>();
+    door["name"] = doorways[i].name;
+    door["in"] = doorways[i].entered;
+    door["out"] = doorways[i].exited;
+    door["people_count"] = doorways[i].occupancy;
+  }
+  if (!mqttClient.beginPublish(mqtt_topic_publish_security_status, measureJson(jsonDoc), false)) {
+    Serial.println("Failed to publish security status");
+    return false;
+  }
+  serializeJson(jsonDoc, mqttClient);
+  if (!mqttClient.endPublish()) {
+    Serial.println("Failed to publish security status");
+    return false;
+  }
+  return true;
 }
 
+// ------------------ 센서별 측정 속도 통계 함수 ------------------
+void printSensorRates(unsigned long elapsedMs) {
+  for (int i = 0; i < activeDoorways; i++) {
+    Serial.printf("[%s] outer %.1f Hz, inner %.1f Hz\n", doorways[i].name,
+                  doorways[i].outer.samples * 1000.0 / elapsedMs,
+                  doorways[i].inner.samples * 1000.0 / elapsedMs);
+  }
+}
+
+void resetSensorSamples() {
+  for (int i = 0; i < doorwayCount; i++) {
+    doorways[i].outer.samples = 0;
+    doorways[i].inner.samples = 0;
+  }
+}
+
+#ifdef SCHEDULER_BENCH
+// ------------------ 스케줄러 벤치마크 함수 ------------------
+// 출입문 수를 1개부터 늘려가며 센서당 초당 측정 횟수를 시리얼로 출력
+// 에코: 150cm 벽 반사 / 반사 없음(HC-SR04 38ms 타임아웃) / 반사 없음(200ms 동안 HIGH인 호환 모듈)
+// 배치: 모든 문이 한 구역(same_zone) / 문마다 다른 구역(separate_zones)
+void runSchedulerBenchmark() {
+  const unsigned long benchDuration = 3000; // 시나리오별 측정 시간(ms)
+  const char* echoNames[] = {"wall_150cm", "no_echo_38ms", "no_echo_200ms"};
+  const unsigned long echoPulses[] = {(unsigned long)(150.0 / 0.017), 38000, 200000};
+  Serial.printf("zone_cycle_us=%lu\n", zoneCycleUs);
+  Serial.println("echo,layout,doorways,min_hz,avg_hz");
+  for (int echo = 0; echo < 3; echo++) {
+    benchEchoPulseUs = echoPulses[echo];
+    for (int layout = 0; layout < 2; layout++) {
+      for (int i = 0; i < doorwayCount; i++) {
+        doorways[i].zone = (layout == 0) ? 0 : i;
+      }
+      for (int n = 1; n <= doorwayCount; n++) {
+        activeDoorways = n;
+        buildSensorSchedule();
+        resetSensorSamples();
+        unsigned long start = millis();
+        while (millis() - start < benchDuration) {
+          serviceSensors();
+        }
+        float minHz = 1e9, sumHz = 0;
+        for (int i = 0; i < n; i++) {
+          float outerHz = doorways[i].outer.samples * 1000.0 / benchDuration;
+          float innerHz = doorways[i].inner.samples * 1000.0 / benchDuration;
+          minHz = min(minHz, min(outerHz, innerHz));
+          sumHz += outerHz + innerHz;
+        }
+        Serial.printf("%s,%s,%d,%.1f,%.1f\n", echoNames[echo], layout == 0 ? "same_zone" : "separate_zones",
+                      n, minHz, sumHz / (2 * n));
+      }
+    }
+  }
+  activeDoorways = doorwayCount;
+  buildSensorSchedule();
+  resetSensorSamples();
+}
+#endif
+
 // ------------------ WiFi 연결 함수 ------------------
 void setup_wifi() {
   delay(10);
@@ -135,11 +475,19 @@ void setup() {
   Serial.begin(115200);
   delay(500); // 시리얼 통신 안정화를 위한 대기
 
-  // 초음파 센서 핀 모드 설정
-  pinMode(trigPin, OUTPUT);
-  pinMode(echoPin, INPUT);
-  pinMode(trigPin2, OUTPUT);
-  pinMode(echoPin2, INPUT);
+#ifndef SCHEDULER_BENCH
+  // 초음파 센서 핀 모드 및 에코 인터럽트 설정 (벤치마크는 에코를 시뮬레이션하므로 생략)
+  for (int i = 0; i < doorwayCount; i++) {
+    UltrasonicSensor* pair[2] = {&doorways[i].outer, &doorways[i].inner};
+    for (int j = 0; j < 2; j++) {
+      pinMode(pair[j]->trigPin, OUTPUT);
+      digitalWrite(pair[j]->trigPin, LOW);
+      pinMode(pair[j]->echoPin, INPUT);
+      attachInterruptArg(digitalPinToInterrupt(pair[j]->echoPin), onEcho, pair[j], CHANGE);
+    }
+  }
+#endif
+  buildSensorSchedule();
 
   // 디스플레이 초기화 및 초기 화면 출력
   display.begin();
@@ -158,6 +506,11 @@ void setup() {
 
   // MQTT 연결 시도
   reconnect();
+
+#ifdef SCHEDULER_BENCH
+  runSchedulerBenchmark();
+#endif
+  lastStatsTime = millis();
 }
 
 // ------------------ 메인 루프 함수 ------------------
@@ -169,94 +522,39 @@ void loop() {
 
   unsigned long currentMillis = millis();
 
-  // ------------------ 초음파 센서로 사람 수 검출 ------------------
-  if (currentMillis - lastSensorCheck >= sensorInterval) {
-    lastSensorCheck = currentMillis;
-
-    // 첫 번째 센서 측정(입구)
-    digitalWrite(trigPin, LOW);
-    delayMicroseconds(2);
-    digitalWrite(trigPin, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(trigPin, LOW);
-    duration1 = pulseIn(echoPin, HIGH, 30000); // 타임아웃 30ms
-    distance1 = duration1 * 0.017; // 거리 계산
-
-    // 두 번째 센서 측정(출구)
-    digitalWrite(trigPin2, LOW);
-    delayMicroseconds(2);
-    digitalWrite(trigPin2, HIGH);
-    delayMicroseconds(10);
-    digitalWrite(trigPin2, LOW);
-    duration2 = pulseIn(echoPin2, HIGH, 30000);
-    distance2 = duration2 * 0.017;
-
-    // 사람이 1번 센서 -> 2번 센서 방향으로 이동한 경우(입장)
-    if (distance1 > 0 && distance1 < 50) {
-      delay(200); // 방향 확인 위해 대기
-      digitalWrite(trigPin2, LOW);
-      delayMicroseconds(2);
-      digitalWrite(trigPin2, HIGH);
-      delayMicroseconds(10);
-      digitalWrite(trigPin2, LOW);
-      
-      duration2 = pulseIn(echoPin2, HIGH, 30000);
-      distance2 = duration2 * 0.017;
-
-      if (distance2 > 0 && distance2 < 50) {
-        Serial.println("1번 -> 2번으로 이동: 사람 들어옴");
-        peopleCount++;
-        delay(500); // 중복 카운트 방지
-        updatePeopleCountOnDisplay();
-      }
+  // ------------------ 초음파 센서 구역별 스케줄링 ------------------
+  if (serviceSensors()) {
+    // 측정이 끝날 때마다 출입문 통과 방향 판정
+    for (int i = 0; i < activeDoorways; i++) {
+      updateDoorway(doorways[i], currentMillis);
     }
+  }
 
-    // 사람이 2번 센서 -> 1번 센서 방향으로 이동한 경우(퇴장)
-    if (distance2 > 0 && distance2 < 50) {
-      delay(200); // 방향 확인 위해 대기
-      digitalWrite(trigPin, LOW);
-      delayMicroseconds(2);
-      digitalWrite(trigPin, HIGH);
-      delayMicroseconds(10);
-      digitalWrite(trigPin, LOW);
-
-      duration1 = pulseIn(echoPin, HIGH, 30000);
-      distance1 = duration1 * 0.017;
-
-      if (distance1 > 0 && distance1 < 50) {
-        Serial.println("2번 -> 1번으로 이동: 사람 나감");
-        peopleCount--;
-        if (peopleCount < 0) peopleCount = 0; // 음수 방지
-        delay(500); // 중복 카운트 방지
-        updatePeopleCountOnDisplay();
-      }
-    }
+  if (currentMillis - lastStatsTime >= statsInterval) {
+    printSensorRates(currentMillis - lastStatsTime);
+    resetSensorSamples();
+    lastStatsTime = currentMillis;
+  }
+
+  // ------------------ 출입문별 인원 수 합산 ------------------
+  if (currentMillis - lastSensorCheck >= sensorInterval) {
+    lastSensorCheck = currentMillis;
+    updatePeopleCount();
 
     // ------------------ 인원 수 변화 시 즉시 MQTT로 상태 전송 ------------------
     if (peopleCount != previousPeopleCount) {
       previousPeopleCount = peopleCount;
-
-      DynamicJsonDocument jsonDoc(200);
-      jsonDoc["people_count"] = peopleCount;
-      jsonDoc["max_people_allowed"] = maxPeopleAllowed;
-      char buffer[256];
-      serializeJson(jsonDoc, buffer);
-      mqttClient.publish(mqtt_topic_publish_security_status, buffer);
-
-      Serial.printf("Published updated people count: %d\n", peopleCount);
+      if (publishSecurityStatus()) {
+        Serial.printf("Published updated people count: %d\n", peopleCount);
+      }
       lastPublishTime = currentMillis; // 마지막 발행 시간 갱신
     }
     // 인원 수 변경이 없으면 일정 주기마다 상태 전송
     else if (currentMillis - lastPublishTime >= publishInterval) {
       lastPublishTime = currentMillis;
-      DynamicJsonDocument jsonDoc(200);
-      jsonDoc["people_count"] = peopleCount;
-      jsonDoc["max_people_allowed"] = maxPeopleAllowed;
-      char buffer[256];
-      serializeJson(jsonDoc, buffer);
-      mqttClient.publish(mqtt_topic_publish_security_status, buffer);
-
-      Serial.printf("Published periodic people count: %d\n", peopleCount);
+      if (publishSecurityStatus()) {
+        Serial.printf("Published periodic people count: %d\n", peopleCount);
+      }
     }
   }
 
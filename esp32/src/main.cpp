@@ -6,6 +6,8 @@
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
 #include <ESP32Servo.h>  // 서보 모터 라이브러리 추가
+#include <esp_timer.h>   // 서보 모션 제어용 하드웨어 타이머
+#include <Preferences.h> // 자동화 규칙 NVS 저장
 
 // ------------------ WiFi 설정 ------------------
 const char* ssid = "iPhone (76)";   // 접속할 WiFi SSID
@@ -20,20 +22,100 @@ const char* mqtt_topic_subscribe_lighting = "home/lighting/command";     // LED
 const char* mqtt_topic_subscribe_humidifier = "home/humidifier/command"; // 가습기 제어 수신 토픽
 const char* mqtt_topic_subscribe_servo = "home/servo/command";           // 서보 모터 제어 명령 수신 토픽
 const char* mqtt_topic_subscribe_security_warn = "home/security/command"; // 초음파 센서 경고 메시지 수신 토픽
+const char* mqtt_topic_subscribe_security_status = "home/security/status"; // 재실 인원 수신 토픽 (자동화 규칙 입력)
+const char* mqtt_topic_subscribe_rules = "home/rules/command";           // 자동화 규칙 설정 수신 토픽
 
 // MQTT 발행(송신) 토픽
 const char* mqtt_topic_publish_lighting = "home/lighting/status";     // LED 상태 발행 토픽
 const char* mqtt_topic_publish_humidifier = "home/humidifier/status"; // 가습기 상태 발행 토픽
 const char* mqtt_topic_publish_sensor = "home/sensor/data";           // 온습도 데이터 발행 토픽
 const char* mqtt_topic_publish_servo_status = "home/servo/status";    // 서보 상태 발행 토픽
+const char* mqtt_topic_publish_rules = "home/rules/status";           // 자동화 규칙 목록 발행 토픽
 
 // ------------------ 핀 설정 ------------------
 const int ledPins[] = {4, 5, 18, 19, 21}; // 제어할 LED의 핀 번호 배열
+const int ledCount = sizeof(ledPins) / sizeof(ledPins[0]); // LED 개수
 #define DHTPIN 22            // DHT22 센서 핀 번호
 #define DHTTYPE DHT22        // DHT 타입(DHT22)
 #define HUMIDIFIER_PIN 23    // 가습기 제어 핀
 #define SERVO_PIN 15         // 서보 모터 핀
 
+// ------------------ 서보 모션 설정 ------------------
+#define SERVO_CLOSED_ANGLE 0     // 문 닫힘 각도
+#define SERVO_OPEN_ANGLE 90      // 문 열림 각도
+#define SERVO_MIN_US 544         // 0도에 해당하는 펄스 폭(us)
+#define SERVO_MAX_US 2400        // 180도에 해당하는 펄스 폭(us)
+#define SERVO_TICK_US 20000      // 모션 갱신 주기(us), 서보 PWM 주기(50Hz)와 동일
+
+// 속도 프로파일 종류
+enum ServoProfile {
+    PROFILE_TRAPEZOID,  // 사다리꼴: 등가속 -> 등속 -> 등감속
+    PROFILE_EASE        // ease-in/out: 코사인 곡선
+};
+
+// 진행 중인 서보 이동 계획
+struct ServoMotion {
+    float brakeAngle;      // 제동 시작 각도 (선점 시 기존 이동을 멈추는 구간)
+    float brakeSpeed;      // 제동 시작 속도(deg/s, 부호 포함)
+    float tBrake;          // 제동 구간 시간(s)
+    float startAngle;      // 본 이동 출발 각도 (제동 후 위치)
+    float targetAngle;     // 목표 각도
+    ServoProfile profile;  // 사용 프로파일
+    float accel;           // 가속도(deg/s^2)
+    float maxSpeed;        // 최고 속도 제한(deg/s)
+    float v0;              // 본 이동 초기 속력(deg/s, 목표 방향 기준)
+    float vPeak;           // 최고 속도(deg/s)
+    float tAccel;          // 첫 가속(또는 maxSpeed까지 감속) 구간 시간(s)
+    float tCruise;         // 등속 구간 시간(s)
+    float total;           // 전체 이동 시간(s, 제동 구간 포함)
+    unsigned long startMicros; // 이동 시작 시각(us)
+    bool active;           // 이동 중 여부
+};
+
+// ------------------ 자동화 규칙 설정 ------------------
+// 서버를 거치지 않고 로컬 센서 값/구독 이벤트로 바로 동작하는 규칙
+// 예) {"id": 1, "if": "humidity", "op": "<", "value": 40, "hysteresis": 5,
+//      "then": "humidifier", "action": "on", "release": "off"}
+//     {"id": 2, "if": "alarm", "then": "lights", "action": "blink"}
+#define MAX_RULES 16
+#define RULE_JSON_MAX 192        // 규칙 하나의 compact JSON 최대 길이
+#define RULES_JSON_MAX (64 + MAX_RULES * RULE_JSON_MAX) // 규칙 명령 전체 최대 길이
+#define RULES_FORMAT_VERSION 2   // NVS 저장 형식 (Rule 구조가 바뀌면 증가, 기본 규칙 재설치)
+#define RULE_EVENT_HOLD_MS 5000  // 이벤트 규칙 재발동 최소 간격 / 해제 대기 시간(ms)
+
+// 규칙 입력
+enum RuleSource { SRC_HUMIDITY, SRC_TEMPERATURE, SRC_PEOPLE, SRC_ALARM };
+const char* const ruleSourceNames[] = {"humidity", "temperature", "people", "alarm"};
+
+// 비교 연산 (alarm은 이벤트 규칙: 첫 이벤트에 동작, 이벤트가 계속되면 RULE_EVENT_HOLD_MS마다 재동작,
+//            RULE_EVENT_HOLD_MS 동안 이벤트가 없으면 해제)
+enum RuleOp { OP_LT, OP_GT, OP_EVENT };
+const char* const ruleOpNames[] = {"<", ">", "event"};
+
+// 제어 대상
+enum RuleTarget { TGT_HUMIDIFIER, TGT_LIGHTS, TGT_LED };
+const char* const ruleTargetNames[] = {"humidifier", "lights", "led"};
+
+// 동작
+enum RuleAction { ACT_NONE, ACT_ON, ACT_OFF, ACT_BLINK };
+const char* const ruleActionNames[] = {"none", "on", "off", "blink"};
+
+// NVS에 그대로 저장되는 규칙 한 개
+struct Rule {
+    uint8_t id;         // 규칙 번호 (1~255)
+    uint8_t source;     // RuleSource
+    uint8_t op;         // RuleOp
+    uint8_t target;     // RuleTarget
+    uint8_t led;        // TGT_LED일 때 LED 번호(1~5)
+    uint8_t action;     // 조건 성립 시 동작
+    uint8_t release;    // 조건이 히스테리시스 밖으로 해제될 때 동작
+    float threshold;    // 비교 기준값
+    float hysteresis;   // 해제 여유폭
+    bool active;        // 조건 성립 상태 (로드 시 초기화)
+    unsigned long lastEvent; // 이벤트 규칙: 마지막 이벤트 수신 시각(ms)
+    unsigned long lastFired; // 이벤트 규칙: 마지막 동작 시각(ms)
+};
+
 DHT dht(DHTPIN, DHTTYPE);   
 Servo myServo;
 
@@ -45,6 +127,43 @@ int interval = 2000;                 // DHT22를 2초마다 읽기
 float humidity = 0;                  // 읽은 습도 값 저장
 float temperature = 0;               // 읽은 온도 값 저장
 
+// 서보 모션 제어 상태 (타이머 태스크와 loop가 공유하므로 servoMux로 보호)
+ServoProfile servoProfile = PROFILE_TRAPEZOID; // 기본 프로파일
+float servoMaxSpeed = 120.0;         // 최대 속도(deg/s)
+float servoAccel = 360.0;            // 가속도(deg/s^2)
+ServoMotion servoMotion = {};        // 현재 이동 계획
+float servoAngle = SERVO_CLOSED_ANGLE; // 현재 출력 각도
+bool servoDonePending = false;       // 이동 완료 상태 발행 대기
+unsigned long servoDoneMillis = 0;   // 완료된 이동의 소요 시간(ms)
+float servoDoneAngle = SERVO_CLOSED_ANGLE; // 완료된 이동의 최종 각도
+portMUX_TYPE servoMux = portMUX_INITIALIZER_UNLOCKED;
+esp_timer_handle_t servoTimer = NULL;
+
+// 자동화 규칙 상태
+Rule rules[MAX_RULES];               // 규칙 목록
+int ruleCount = 0;                   // 등록된 규칙 수
+Preferences prefs;                   // NVS 접근 객체
+bool dhtValid = false;               // 유효한 DHT22 값을 한 번이라도 읽었는지 (규칙 재평가용)
+int lastPeopleCount = -1;            // 마지막으로 수신한 재실 인원 (-1: 미수신)
+
+// LED 깜빡임 패턴 상태 (loop를 막지 않도록 millis 기반으로 진행)
+int blinkRemaining = 0;              // 남은 켜기/끄기 전환 횟수
+unsigned long lastBlinkToggle = 0;   // 마지막 전환 시간
+const unsigned long blinkInterval = 500; // 깜빡임 간격(ms)
+
+// MQTT 재연결 시도 간격 (브로커가 꺼져 있어도 loop와 로컬 규칙은 계속 동작)
+unsigned long lastReconnectAttempt = 0;
+const unsigned long reconnectInterval = 5000;
+
+// 브로커 연결 확인 태스크: 브로커 호스트가 꺼져 있으면 TCP 연결이 타임아웃(기본 3s)까지 막히므로
+// 별도 태스크에서 포트 연결만 확인하고, loop는 확인에 성공했을 때만 client.connect()를 호출한다.
+// (PubSubClient는 loop 태스크에서만 사용)
+TaskHandle_t brokerProbeTask = NULL;
+volatile bool brokerProbeDone = false;  // 확인 완료 (loop에서 결과 소비)
+volatile bool brokerReachable = false;  // 마지막 확인에서 브로커 포트 연결 성공 여부
+bool brokerProbePending = false;        // 확인 요청 후 결과 대기 중
+const uint32_t mqttConnectTimeoutSec = 1; // 확인 후 실제 접속 시 TCP 연결/응답 대기 한도(s)
+
 // ------------------ WiFi 연결 함수 ------------------
 void setup_wifi() {
     delay(10);
@@ -74,11 +193,588 @@ void setup_wifi() {
 }
 
 // ------------------ 서보 상태 발행 함수 ------------------
-void publishServoStatus(const char* status) {
-    // 서보 모터 상태("on"/"off")를 MQTT로 발행
-    client.publish(mqtt_topic_publish_servo_status, status);
+void publishServoStatus(const char* status, float angle, long durationMs) {
+    // 서보 상태("moving"/"open"/"closed")와 각도, 이동 소요 시간을 MQTT로 발행
+    JsonDocument statusDoc;
+    statusDoc["status"] = status;
+    statusDoc["angle"] = (int)lroundf(angle);
+    if (durationMs >= 0) {
+        statusDoc["duration_ms"] = durationMs;
+    }
+    char statusBuffer[256];
+    serializeJson(statusDoc, statusBuffer);
+    client.publish(mqtt_topic_publish_servo_status, statusBuffer);
+}
+
+// ------------------ 서보 모션 계획 함수 ------------------
+// fromAngle에서 velocity(deg/s, 부호 포함)로 움직이는 중인 서보를 m.targetAngle로 보내는 계획을 세운다.
+// 반대 방향으로 움직이는 중이거나 목표 전에 멈출 수 없으면 먼저 accel로 제동한 뒤 정지 상태에서 다시 출발한다.
+void planServoMotion(ServoMotion& m, float fromAngle, float velocity, float maxSpeed, float accel) {
+    m.accel = accel;
+    m.maxSpeed = maxSpeed;
+    m.brakeAngle = fromAngle;
+    m.brakeSpeed = 0;
+    m.tBrake = 0;
+    m.tCruise = 0;
+
+    float dir = (m.targetAngle >= fromAngle) ? 1.0 : -1.0;
+    float along = velocity * dir; // 목표 방향 속력
+    float distance = fabsf(m.targetAngle - fromAngle);
+    bool brake = along < 0 || along * along > 2.0 * accel * distance ||
+                 (m.profile == PROFILE_EASE && velocity != 0); // 코사인 곡선은 정지 상태에서만 시작
+    if (brake && velocity != 0) {
+        m.brakeSpeed = velocity;
+        m.tBrake = fabsf(velocity) / accel;
+        fromAngle += velocity * m.tBrake / 2.0;
+        along = 0;
+    }
+    m.startAngle = fromAngle;
+    m.v0 = max(along, 0.0f);
+    distance = fabsf(m.targetAngle - fromAngle);
+
+    if (m.profile == PROFILE_EASE) {
+        // s(t) = D * (1 - cos(pi * t / T)) / 2
+        // 최고 속도 pi*D/(2T), 최고 가속도 pi^2*D/(2T^2)가 한계를 넘지 않는 최소 T 선택
+        float tBySpeed = PI * distance / (2.0 * maxSpeed);
+        float tByAccel = PI * sqrtf(distance / (2.0 * accel));
+        float tMove = max(tBySpeed, tByAccel);
+        m.tAccel = tMove / 2.0;
+        m.vPeak = (tMove > 0) ? PI * distance / (2.0 * tMove) : 0;
+        m.total = m.tBrake + tMove;
+        return;
+    }
+
+    // 사다리꼴: 초기 속력 v0에서 maxSpeed까지 가속(v0가 더 빠르면 감속) -> 등속 -> 정지,
+    // 최고 속도에 못 미치면 삼각형 프로파일
+    // (v0 > maxSpeed면 제동 조건에 의해 v0에서 정지 거리 <= distance이므로 항상 등속 구간이 생김)
+    float dAccel = fabsf(maxSpeed * maxSpeed - m.v0 * m.v0) / (2.0 * accel);
+    float dDecel = maxSpeed * maxSpeed / (2.0 * accel);
+    if (m.v0 > maxSpeed || dAccel + dDecel <= distance) {
+        m.vPeak = maxSpeed;
+        m.tCruise = max(distance - dAccel - dDecel, 0.0f) / maxSpeed;
+    } else {
+        m.vPeak = sqrtf(accel * distance + m.v0 * m.v0 / 2.0);
+    }
+    m.tAccel = fabsf(m.vPeak - m.v0) / accel;
+    m.total = m.tBrake + m.tAccel + m.tCruise + m.vPeak / accel;
+}
+
+// ------------------ 서보 프로파일 위치/속도 계산 함수 ------------------
+float servoProfileAngle(const ServoMotion& m, float t) {
+    if (t >= m.total) {
+        return m.targetAngle;
+    }
+    if (t < m.tBrake) {
+        // 제동 구간: 기존 속도에서 등감속
+        float decel = (m.brakeSpeed > 0) ? -m.accel : m.accel;
+        return m.brakeAngle + m.brakeSpeed * t + 0.5 * decel * t * t;
+    }
+    t -= m.tBrake;
+    float tMove = m.total - m.tBrake;
+    float distance = fabsf(m.targetAngle - m.startAngle);
+    float a1 = (m.vPeak >= m.v0) ? m.accel : -m.accel; // 첫 구간 가감속도
+    float s; // 출발점으로부터 이동한 거리(deg)
+
+    if (m.profile == PROFILE_EASE) {
+        s = distance * (1.0 - cosf(PI * t / tMove)) / 2.0;
+    } else if (t < m.tAccel) {
+        s = m.v0 * t + 0.5 * a1 * t * t;
+    } else if (t < m.tAccel + m.tCruise) {
+        s = (m.vPeak * m.vPeak - m.v0 * m.v0) / (2.0 * a1) + m.vPeak * (t - m.tAccel);
+    } else {
+        float tLeft = tMove - t;
+        s = distance - 0.5 * m.accel * tLeft * tLeft;
+    }
+    return (m.targetAngle >= m.startAngle) ? m.startAngle + s : m.startAngle - s;
+}
+
+float servoProfileVelocity(const ServoMotion& m, float t) {
+    // 시각 t의 속도(deg/s, 부호 포함)
+    if (t >= m.total) {
+        return 0;
+    }
+    if (t < m.tBrake) {
+        return (m.brakeSpeed > 0) ? m.brakeSpeed - m.accel * t : m.brakeSpeed + m.accel * t;
+    }
+    t -= m.tBrake;
+    float tMove = m.total - m.tBrake;
+    float v;
+
+    if (m.profile == PROFILE_EASE) {
+        v = m.vPeak * sinf(PI * t / tMove);
+    } else if (t < m.tAccel) {
+        v = (m.vPeak >= m.v0) ? m.v0 + m.accel * t : m.v0 - m.accel * t;
+    } else if (t < m.tAccel + m.tCruise) {
+        v = m.vPeak;
+    } else {
+        v = m.accel * (tMove - t);
+    }
+    return (m.targetAngle >= m.startAngle) ? v : -v;
+}
+
+// ------------------ 서보 타이머 콜백 함수 ------------------
+// esp_timer 태스크에서 SERVO_TICK_US마다 호출되어 loop의 지연(깜빡임, 재연결)과 무관하게 서보를 움직인다.
+void onServoTimer(void* arg) {
+    portENTER_CRITICAL(&servoMux);
+    if (!servoMotion.active) {
+        portEXIT_CRITICAL(&servoMux);
+        return;
+    }
+    unsigned long elapsed = micros() - servoMotion.startMicros;
+    float angle = servoProfileAngle(servoMotion, elapsed / 1000000.0);
+    if (elapsed >= servoMotion.total * 1000000.0) {
+        // 목표 도달: 완료 상태는 loop에서 MQTT로 발행
+        servoMotion.active = false;
+        servoDonePending = true;
+        servoDoneMillis = elapsed / 1000;
+        servoDoneAngle = angle;
+    }
+    servoAngle = angle;
+    portEXIT_CRITICAL(&servoMux);
+
+    // 제동 중 관성으로 가동 범위를 넘는 구간은 끝점에서 멈춤
+    angle = constrain(angle, 0, 180);
+    myServo.writeMicroseconds(map((long)(angle * 10), 0, 1800, SERVO_MIN_US, SERVO_MAX_US));
 }
 
+// ------------------ 서보 이동 시작 함수 ------------------
+void startServoMove(float targetAngle, ServoProfile profile) {
+    targetAngle = constrain(targetAngle, 0, 180);
+
+    // 이동 중이면 현재 위치와 속도에서 새 목표로 재계획 (선점)
+    portENTER_CRITICAL(&servoMux);
+    if (servoMotion.active && servoMotion.targetAngle == targetAngle && servoMotion.profile == profile &&
+        servoMotion.maxSpeed == servoMaxSpeed && servoMotion.accel == servoAccel) {
+        // 이미 같은 목표로 같은 설정으로 이동 중이면 무시 (중복 클릭에 멈췄다 다시 출발하지 않도록)
+        portEXIT_CRITICAL(&servoMux);
+        return;
+    }
+    bool preempted = servoMotion.active;
+    unsigned long now = micros();
+    float velocity = preempted ? servoProfileVelocity(servoMotion, (now - servoMotion.startMicros) / 1000000.0) : 0;
+    servoMotion.targetAngle = targetAngle;
+    servoMotion.profile = profile;
+    planServoMotion(servoMotion, servoAngle, velocity, servoMaxSpeed, servoAccel);
+    servoMotion.startMicros = now;
+    servoMotion.active = true;
+    servoDonePending = false;
+    portEXIT_CRITICAL(&servoMux);
+
+    Serial.printf("Servo: moving to %.0f deg%s\n", targetAngle, preempted ? " (preempted)" : "");
+    publishServoStatus("moving", targetAngle, -1);
+}
+
+// ------------------ 서보 완료 상태 처리 함수 ------------------
+void updateServo() {
+    // 타이머 콜백에서 이동이 끝나면 최종 상태를 발행
+    portENTER_CRITICAL(&servoMux);
+    bool done = servoDonePending;
+    servoDonePending = false;
+    float angle = servoDoneAngle;
+    unsigned long durationMs = servoDoneMillis;
+    portEXIT_CRITICAL(&servoMux);
+
+    if (done) {
+        const char* status = (angle <= SERVO_CLOSED_ANGLE) ? "closed" : "open";
+        Serial.printf("Servo: Door %s (%lu ms)\n", status, durationMs);
+        publishServoStatus(status, angle, durationMs);
+    }
+}
+
+// ------------------ 조명 / 가습기 제어 함수 ------------------
+void publishLedStatus(int ledIndex) {
+    // 현재 LED 상태 MQTT 발행
+    JsonDocument statusDoc;
+    statusDoc["led"] = ledIndex + 1;
+    statusDoc["status"] = (digitalRead(ledPins[ledIndex]) == HIGH) ? "on" : "off";
+    char statusBuffer[256];
+    serializeJson(statusDoc, statusBuffer);
+    client.publish(mqtt_topic_publish_lighting, statusBuffer);
+}
+
+void setLed(int ledIndex, bool on) {
+    digitalWrite(ledPins[ledIndex], on ? HIGH : LOW);
+    publishLedStatus(ledIndex);
+}
+
+void setAllLeds(bool on) {
+    for (int i = 0; i < ledCount; i++) {
+        digitalWrite(ledPins[i], on ? HIGH : LOW);
+    }
+    // 전체 LED 상태 MQTT 발행
+    JsonDocument statusDoc;
+    statusDoc["status"] = on ? "on" : "off";
+    char statusBuffer[256];
+    serializeJson(statusDoc, statusBuffer);
+    client.publish(mqtt_topic_publish_lighting, statusBuffer);
+}
+
+void setHumidifier(bool on) {
+    digitalWrite(HUMIDIFIER_PIN, on ? HIGH : LOW);
+    // 현재 가습기 상태 MQTT 발행
+    JsonDocument statusDoc;
+    statusDoc["status"] = on ? "on" : "off";
+    char statusBuffer[256];
+    serializeJson(statusDoc, statusBuffer);
+    client.publish(mqtt_topic_publish_humidifier, statusBuffer);
+}
+
+// ------------------ LED 깜빡임 패턴 함수 ------------------
+void updateBlink() {
+    if (blinkRemaining > 0 && millis() - lastBlinkToggle >= blinkInterval) {
+        lastBlinkToggle = millis();
+        // 남은 횟수가 짝수면 켜기, 홀수면 끄기 (마지막은 항상 꺼짐)
+        int level = (blinkRemaining % 2 == 0) ? HIGH : LOW;
+        for (int i = 0; i < ledCount; i++) {
+            digitalWrite(ledPins[i], level);
+        }
+        blinkRemaining--;
+    }
+}
+
+void startBlink(int times) {
+    if (blinkRemaining > 0) {
+        // 이미 깜빡이는 중이면 현재 점멸 위상을 유지한 채 남은 횟수만 연장
+        blinkRemaining = times * 2 + blinkRemaining % 2;
+        return;
+    }
+    blinkRemaining = times * 2;
+    lastBlinkToggle = millis() - blinkInterval;
+    updateBlink(); // 첫 점등은 즉시
+}
+
+// ------------------ 자동화 규칙 파싱 함수 ------------------
+int findName(const char* const names[], int count, const char* name) {
+    if (name == NULL) return -1;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+bool parseRule(JsonObject obj, Rule& rule) {
+    int id = obj["id"] | 0;
+    int source = findName(ruleSourceNames, 4, obj["if"]);
+    int target = findName(ruleTargetNames, 3, obj["then"]);
+    int action = findName(ruleActionNames, 4, obj["action"]);
+    int release = findName(ruleActionNames, 4, obj["release"] | "none");
+    if (id < 1 || id > 255 || source < 0 || target < 0 || action <= ACT_NONE || release < 0) {
+        return false;
+    }
+
+    int op = OP_EVENT;
+    if (source != SRC_ALARM) {
+        op = findName(ruleOpNames, 2, obj["op"] | "<");
+        if (op < 0) return false;
+    }
+
+    int led = obj["led"] | 0;
+    if (target == TGT_LED && (led < 1 || led > ledCount)) return false;
+    // 깜빡임 패턴은 전체 조명에만 적용
+    if ((action == ACT_BLINK || release == ACT_BLINK) && target != TGT_LIGHTS) return false;
+
+    rule.id = id;
+    rule.source = source;
+    rule.op = op;
+    rule.target = target;
+    rule.led = led;
+    rule.action = action;
+    rule.release = release;
+    rule.threshold = obj["value"] | 0.0f;
+    rule.hysteresis = fabsf(obj["hysteresis"] | 0.0f);
+    rule.active = false;
+    return true;
+}
+
+void ruleToJson(const Rule& rule, JsonObject obj) {
+    obj["id"] = rule.id;
+    obj["if"] = ruleSourceNames[rule.source];
+    if (rule.op != OP_EVENT) {
+        obj["op"] = ruleOpNames[rule.op];
+        obj["value"] = rule.threshold;
+        obj["hysteresis"] = rule.hysteresis;
+    }
+    obj["then"] = ruleTargetNames[rule.target];
+    if (rule.target == TGT_LED) {
+        obj["led"] = rule.led;
+    }
+    obj["action"] = ruleActionNames[rule.action];
+    obj["release"] = ruleActionNames[rule.release];
+    obj["active"] = rule.active;
+}
+
+// ------------------ 자동화 규칙 저장/불러오기 함수 ------------------
+void saveRules() {
+    prefs.begin("rules", false);
+    prefs.putBytes("list", rules, sizeof(Rule) * ruleCount);
+    prefs.putUChar("count", ruleCount);
+    prefs.putUChar("ver", RULES_FORMAT_VERSION);
+    prefs.end();
+}
+
+void loadRules() {
+    prefs.begin("rules", true);
+    bool stored = prefs.getUChar("ver", 0) == RULES_FORMAT_VERSION;
+    ruleCount = prefs.getUChar("count", 0);
+    if (!stored || ruleCount > MAX_RULES ||
+        (ruleCount > 0 && prefs.getBytes("list", rules, sizeof(rules)) != sizeof(Rule) * ruleCount)) {
+        ruleCount = 0; // 저장 형식이 맞지 않으면 무시
+    }
+    prefs.end();
+
+    if (!stored) {
+        // 최초 부팅(또는 저장 형식 변경): 기본 규칙 설치
+        // 1) 습도 40% 미만이면 가습기 켜고 45% 이상이면 끔
+        // 2) 보안 경보 수신 시 전체 조명 깜빡임 (기존 고정 동작)
+        rules[0] = {1, SRC_HUMIDITY, OP_LT, TGT_HUMIDIFIER, 0, ACT_ON, ACT_OFF, 40.0f, 5.0f};
+        rules[1] = {2, SRC_ALARM, OP_EVENT, TGT_LIGHTS, 0, ACT_BLINK, ACT_NONE, 0.0f, 0.0f};
+        ruleCount = 2;
+        saveRules();
+    }
+    for (int i = 0; i < ruleCount; i++) {
+        rules[i].active = false;
+    }
+    Serial.printf("Loaded %d automation rules\n", ruleCount);
+}
+
+void publishRulesStatus(const char* error) {
+    // 규칙 목록(및 오류)을 measureJson으로 길이를 구해 버퍼 없이 스트리밍 발행
+    JsonDocument statusDoc;
+    JsonArray list = statusDoc["rules"].to<JsonArray>();
+    for (int i = 0; i < ruleCount; i++) {
+        ruleToJson(rules[i], list.add<JsonObject>());
+    }
+    if (error != NULL) {
+        statusDoc["error"] = error;
+        Serial.printf("Rules: %s\n", error);
+    }
+    if (!client.beginPublish(mqtt_topic_publish_rules, measureJson(statusDoc), false)) {
+        Serial.println("Rules: status publish failed");
+        return;
+    }
+    serializeJson(statusDoc, client);
+    if (!client.endPublish()) {
+        Serial.println("Rules: status publish failed");
+    }
+}
+
+// ------------------ 자동화 규칙 평가 함수 ------------------
+// 상태 전이에 따라 실행할 동작 반환 (변화가 없으면 ACT_NONE)
+uint8_t ruleTransition(Rule& rule, float value, unsigned long nowMillis) {
+    switch (rule.op) {
+        case OP_EVENT:
+            // 경보가 반복 수신되어도 RULE_EVENT_HOLD_MS마다 한 번만 동작
+            rule.lastEvent = nowMillis;
+            if (!rule.active || nowMillis - rule.lastFired >= RULE_EVENT_HOLD_MS) {
+                rule.active = true;
+                rule.lastFired = nowMillis;
+                return rule.action;
+            }
+            break;
+        case OP_LT:
+            if (!rule.active && value < rule.threshold) {
+                rule.active = true;
+                return rule.action;
+            }
+            if (rule.active && value >= rule.threshold + rule.hysteresis) {
+                rule.active = false;
+                return rule.release;
+            }
+            break;
+        case OP_GT:
+            if (!rule.active && value > rule.threshold) {
+                rule.active = true;
+                return rule.action;
+            }
+            if (rule.active && value <= rule.threshold - rule.hysteresis) {
+                rule.active = false;
+                return rule.release;
+            }
+            break;
+    }
+    return ACT_NONE;
+}
+
+void applyRuleAction(const Rule& rule, uint8_t action) {
+    switch (rule.target) {
+        case TGT_HUMIDIFIER:
+            if (action == ACT_ON || action == ACT_OFF) setHumidifier(action == ACT_ON);
+            break;
+        case TGT_LIGHTS:
+            if (action == ACT_BLINK) {
+                startBlink(5);
+            } else if (action == ACT_ON || action == ACT_OFF) {
+                setAllLeds(action == ACT_ON);
+            }
+            break;
+        case TGT_LED:
+            if (action == ACT_ON || action == ACT_OFF) setLed(rule.led - 1, action == ACT_ON);
+            break;
+    }
+}
+
+// inputMicros: 입력(MQTT 수신 또는 DHT22 측정 완료) 시각, 구동까지 걸린 시간 출력용
+void evaluateRules(uint8_t source, float value, unsigned long inputMicros) {
+    unsigned long now = millis();
+    for (int i = 0; i < ruleCount; i++) {
+        if (rules[i].source != source) continue;
+        uint8_t action = ruleTransition(rules[i], value, now);
+        if (action != ACT_NONE) {
+            applyRuleAction(rules[i], action);
+            Serial.printf("Rule %d: %s %s (%lu us from input)\n", rules[i].id,
+                          ruleTargetNames[rules[i].target], ruleActionNames[action], micros() - inputMicros);
+        }
+    }
+}
+
+void releaseRule(Rule& rule) {
+    // 성립 중인 규칙의 해제 동작 실행
+    if (rule.active && rule.release != ACT_NONE) {
+        applyRuleAction(rule, rule.release);
+        Serial.printf("Rule %d: %s %s (released)\n", rule.id,
+                      ruleTargetNames[rule.target], ruleActionNames[rule.release]);
+    }
+    rule.active = false;
+}
+
+void updateEventRules() {
+    // RULE_EVENT_HOLD_MS 동안 이벤트가 없으면 이벤트 규칙 해제
+    unsigned long now = millis();
+    for (int i = 0; i < ruleCount; i++) {
+        if (rules[i].op == OP_EVENT && rules[i].active && now - rules[i].lastEvent >= RULE_EVENT_HOLD_MS) {
+            releaseRule(rules[i]);
+        }
+    }
+}
+
+void reevaluateRules() {
+    // 규칙 변경 후 마지막 센서 값으로 다시 평가
+    if (dhtValid) {
+        evaluateRules(SRC_HUMIDITY, humidity, micros());
+        evaluateRules(SRC_TEMPERATURE, temperature, micros());
+    }
+    if (lastPeopleCount >= 0) {
+        evaluateRules(SRC_PEOPLE, lastPeopleCount, micros());
+    }
+}
+
+// ------------------ 자동화 규칙 명령 처리 함수 ------------------
+bool sameRuleConfig(const Rule& a, const Rule& b) {
+    return a.id == b.id && a.source == b.source && a.op == b.op && a.target == b.target &&
+           a.led == b.led && a.action == b.action && a.release == b.release &&
+           a.threshold == b.threshold && a.hysteresis == b.hysteresis;
+}
+
+void replaceRules(Rule* next, int count) {
+    // 설정이 그대로인 규칙은 상태를 이어받고, 바뀌거나 삭제되는 성립 중 규칙은 해제 동작 실행
+    for (int i = 0; i < ruleCount; i++) {
+        bool kept = false;
+        for (int j = 0; j < count; j++) {
+            if (sameRuleConfig(rules[i], next[j])) {
+                next[j].active = rules[i].active;
+                next[j].lastEvent = rules[i].lastEvent;
+                next[j].lastFired = rules[i].lastFired;
+                kept = true;
+                break;
+            }
+        }
+        if (!kept) releaseRule(rules[i]);
+    }
+    memcpy(rules, next, sizeof(Rule) * count);
+    ruleCount = count;
+    saveRules();
+    reevaluateRules();
+}
+
+void handleRulesCommand(JsonDocument& doc) {
+    String command = doc["command"] | "list";
+    Rule next[MAX_RULES];
+    int count = 0;
+
+    if (command == "set") {
+        // 규칙 목록 전체 교체 (빈 배열이면 모두 삭제)
+        if (!doc["rules"].is<JsonArray>()) {
+            publishRulesStatus("set requires a rules array");
+            return;
+        }
+        for (JsonObject obj : doc["rules"].as<JsonArray>()) {
+            if (count >= MAX_RULES) {
+                publishRulesStatus("too many rules");
+                return;
+            }
+            if (!parseRule(obj, next[count])) {
+                publishRulesStatus("invalid rule in set");
+                return;
+            }
+            for (int j = 0; j < count; j++) {
+                if (next[j].id == next[count].id) {
+                    publishRulesStatus("duplicate rule id");
+                    return;
+                }
+            }
+            count++;
+        }
+        replaceRules(next, count);
+    } else if (command == "add") {
+        // 같은 id가 있으면 교체, 없으면 추가
+        Rule rule;
+        if (!parseRule(doc["rule"].as<JsonObject>(), rule)) {
+            publishRulesStatus("invalid rule");
+            return;
+        }
+        memcpy(next, rules, sizeof(Rule) * ruleCount);
+        count = ruleCount;
+        int i = 0;
+        while (i < count && next[i].id != rule.id) i++;
+        if (i == MAX_RULES) {
+            publishRulesStatus("rule table full");
+            return;
+        }
+        next[i] = rule;
+        if (i == count) count++;
+        replaceRules(next, count);
+    } else if (command == "delete") {
+        int id = doc["id"] | 0;
+        for (int i = 0; i < ruleCount; i++) {
+            if (rules[i].id != id) next[count++] = rules[i];
+        }
+        if (count == ruleCount) {
+            publishRulesStatus("unknown rule id");
+            return;
+        }
+        replaceRules(next, count);
+    } else if (command != "list") {
+        publishRulesStatus("unknown command");
+        return;
+    }
+    publishRulesStatus(NULL);
+}
+
+#ifdef RULES_BENCH
+// ------------------ 자동화 규칙 벤치마크 함수 ------------------
+// MAX_RULES개 규칙을 반복 평가해 규칙당 평가 시간을 시리얼로 출력 (구동 제외)
+void runRulesBenchmark() {
+    Rule benchRules[MAX_RULES];
+    for (int i = 0; i < MAX_RULES; i++) {
+        benchRules[i] = {(uint8_t)(i + 1), SRC_HUMIDITY, (uint8_t)(i % 2 ? OP_GT : OP_LT), TGT_LED, 1,
+                         ACT_ON, ACT_OFF, 40.0f, 5.0f};
+    }
+    const int iterations = 10000;
+    unsigned long transitions = 0;
+    unsigned long start = micros();
+    for (int n = 0; n < iterations; n++) {
+        // 매번 임계값을 넘나드는 값으로 상태 전이 경로까지 포함
+        float value = (n % 2) ? 30.0f : 50.0f;
+        for (int i = 0; i < MAX_RULES; i++) {
+            if (ruleTransition(benchRules[i], value, n) != ACT_NONE) transitions++;
+        }
+    }
+    unsigned long elapsed = micros() - start;
+    Serial.printf("Rules bench: %d rules x %d evals, %.3f us/rule, %lu transitions\n",
+                  MAX_RULES, iterations, (float)elapsed / ((float)iterations * MAX_RULES), transitions);
+}
+#endif
+
 // ------------------ DHT22 센서 읽기 함수 ------------------
 void readDHT22() {
     unsigned long currentMillis = millis();
@@ -87,6 +783,7 @@ void readDHT22() {
         lastDHTReadMillis = currentMillis;
         humidity = dht.readHumidity();       // 습도 읽기
         temperature = dht.readTemperature(); // 온도 읽기
+        unsigned long readMicros = micros(); // 규칙 구동 지연 측정 기준
 
         if (!isnan(humidity) && !isnan(temperature)) {
             // NaN이 아닐 경우만 유효한 데이터
@@ -96,18 +793,24 @@ void readDHT22() {
             dtostrf(humidity, 4, 2, humidityStr);       // 습도값 문자열 변환
 
             // JSON 형태로 데이터 구성 후 MQTT 발행
-            StaticJsonDocument<200> jsonDoc;
+            JsonDocument jsonDoc;
             jsonDoc["temperature"] = temperatureStr;
             jsonDoc["humidity"] = humidityStr;
             char buffer[256];
             serializeJson(jsonDoc, buffer);
             client.publish(mqtt_topic_publish_sensor, buffer);
+
+            // 로컬 자동화 규칙 평가
+            dhtValid = true;
+            evaluateRules(SRC_HUMIDITY, humidity, readMicros);
+            evaluateRules(SRC_TEMPERATURE, temperature, readMicros);
         }
     }
 }
 
 // ------------------ MQTT 메시지 콜백 함수 ------------------
 void callback(char* topic, byte* payload, unsigned int length) {
+    unsigned long receivedMicros = micros(); // 규칙 구동 지연 측정 기준
     payload[length] = '\0'; // 수신 데이터 끝에 널 문자 추가해 문자열로 변환
     String message = String((char*)payload);
 
@@ -116,111 +819,132 @@ void callback(char* topic, byte* payload, unsigned int length) {
     Serial.print("]: ");
     Serial.println(message);
 
-    StaticJsonDocument<256> doc;
+    JsonDocument doc;
     // 수신한 메시지를 JSON으로 파싱
     DeserializationError error = deserializeJson(doc, message);
 
     if (error) {
         Serial.print("deserializeJson() failed: ");
         Serial.println(error.f_str());
+        if (strcmp(topic, mqtt_topic_subscribe_rules) == 0) {
+            publishRulesStatus(error.c_str());
+        }
         return;
     }
 
     // ------------------ 조명 제어 처리 ------------------
     if (strcmp(topic, mqtt_topic_subscribe_lighting) == 0) {
-        if (doc.containsKey("led") && doc.containsKey("status")) {
+        if (doc["led"].is<int>() && doc["status"].is<const char*>()) {
             // 특정 LED 제어
             int ledIndex = doc["led"].as<int>() - 1; // led=1이면 index=0
             String status = doc["status"].as<String>();
-            if (ledIndex >= 0 && ledIndex < (int)(sizeof(ledPins) / sizeof(ledPins[0]))) {
-                // "on"/"off"에 따라 LED 핀 상태 설정
+            if (ledIndex >= 0 && ledIndex < ledCount) {
+                // "on"/"off"에 따라 LED 핀 상태 설정 후 현재 상태 발행
                 if (status == "on") {
-                    digitalWrite(ledPins[ledIndex], HIGH);
+                    setLed(ledIndex, true);
                 } else if (status == "off") {
-                    digitalWrite(ledPins[ledIndex], LOW);
+                    setLed(ledIndex, false);
+                } else {
+                    publishLedStatus(ledIndex);
                 }
-                // 현재 LED 상태 MQTT 발행
-                StaticJsonDocument<200> statusDoc;
-                statusDoc["led"] = ledIndex + 1;
-                statusDoc["status"] = (digitalRead(ledPins[ledIndex]) == HIGH) ? "on" : "off";
-                char statusBuffer[256];
-                serializeJson(statusDoc, statusBuffer);
-                client.publish(mqtt_topic_publish_lighting, statusBuffer);
             }
-        } else if (doc.containsKey("status")) {
+        } else if (doc["status"].is<const char*>()) {
             // 모든 LED에 대한 일괄 제어
             String status = doc["status"].as<String>();
-            int newStatus = (status == "on") ? HIGH : LOW;
-            for (int i = 0; i < (int)(sizeof(ledPins) / sizeof(ledPins[0])); i++) {
-                digitalWrite(ledPins[i], newStatus);
-            }
-            // 전체 LED 상태 MQTT 발행
-            StaticJsonDocument<200> statusDoc;
-            statusDoc["status"] = status;
-            char statusBuffer[256];
-            serializeJson(statusDoc, statusBuffer);
-            client.publish(mqtt_topic_publish_lighting, statusBuffer);
+            setAllLeds(status == "on");
         }
 
     // ------------------ 가습기 제어 처리 ------------------
     } else if (strcmp(topic, mqtt_topic_subscribe_humidifier) == 0) {
-        if (doc.containsKey("status")) {
+        if (doc["status"].is<const char*>()) {
             String status = doc["status"].as<String>();
             // "on"/"off"에 따라 가습기 핀 상태 설정
             if (status == "on") {
-                digitalWrite(HUMIDIFIER_PIN, HIGH);
+                setHumidifier(true);
             } else if (status == "off") {
-                digitalWrite(HUMIDIFIER_PIN, LOW);
+                setHumidifier(false);
             }
-            // 현재 가습기 상태 MQTT 발행
-            StaticJsonDocument<200> statusDoc;
-            statusDoc["status"] = status;
-            char statusBuffer[256];
-            serializeJson(statusDoc, statusBuffer);
-            client.publish(mqtt_topic_publish_humidifier, statusBuffer);
         }
 
     // ------------------ 서보 모터 제어 처리 ------------------
     } else if (strcmp(topic, mqtt_topic_subscribe_servo) == 0) {
-        if (doc.containsKey("command")) {
+        // 모션 파라미터 변경 (이후 명령부터 적용)
+        if (doc["speed"].is<float>() && doc["speed"].as<float>() > 0) {
+            servoMaxSpeed = doc["speed"].as<float>();
+        }
+        if (doc["accel"].is<float>() && doc["accel"].as<float>() > 0) {
+            servoAccel = doc["accel"].as<float>();
+        }
+        if (doc["profile"].is<const char*>()) {
+            String profile = doc["profile"].as<String>();
+            if (profile == "ease") {
+                servoProfile = PROFILE_EASE;
+            } else if (profile == "trapezoid") {
+                servoProfile = PROFILE_TRAPEZOID;
+            }
+        }
+
+        if (doc["angle"].is<float>()) {
+            // 임의의 목표 각도로 이동
+            startServoMove(doc["angle"].as<float>(), servoProfile);
+        } else if (doc["command"].is<const char*>()) {
             String command = doc["command"].as<String>();
             // "on"이면 문 열기(서보 90도), "off"이면 문 닫기(서보 0도)
             if (command == "on") {
-                myServo.write(90);
-                Serial.println("Servo: Door Open");
-                publishServoStatus("on");
+                startServoMove(SERVO_OPEN_ANGLE, servoProfile);
             } else if (command == "off") {
-                myServo.write(0);
-                Serial.println("Servo: Door Closed");
-                publishServoStatus("off");
+                startServoMove(SERVO_CLOSED_ANGLE, servoProfile);
             }
         }
 
     // ------------------ 경고 메시지 수신 처리 ------------------
     } else if (strcmp(topic, mqtt_topic_subscribe_security_warn) == 0) {
         // 경고 수신 시 모든 LED 깜빡이는 동작
-        if (doc.containsKey("command")){
+        if (doc["command"].is<const char*>()) {
             String command = doc["command"].as<String>();
             if (command == "blink") {
-                for (int i = 0; i < 5; i++) { // 5회 깜빡임
-                    for (int j = 0; j < (int)(sizeof(ledPins) / sizeof(ledPins[0])); j++) {
-                        digitalWrite(ledPins[j], HIGH);
-                    }
-                    delay(500); // 500ms 켜기
-                    for (int j = 0; j < (int)(sizeof(ledPins) / sizeof(ledPins[0])); j++) {
-                        digitalWrite(ledPins[j], LOW);
-                    }
-                    delay(500); // 500ms 끄기
-                }
+                // 경보에 대한 동작은 자동화 규칙으로 처리 (기본 규칙: 전체 조명 깜빡임)
+                evaluateRules(SRC_ALARM, 1, receivedMicros);
             }
         }
+
+    // ------------------ 재실 인원 수신 처리 ------------------
+    } else if (strcmp(topic, mqtt_topic_subscribe_security_status) == 0) {
+        if (doc["people_count"].is<int>()) {
+            lastPeopleCount = doc["people_count"].as<int>();
+            evaluateRules(SRC_PEOPLE, lastPeopleCount, receivedMicros);
+        }
+
+    // ------------------ 자동화 규칙 설정 처리 ------------------
+    } else if (strcmp(topic, mqtt_topic_subscribe_rules) == 0) {
+        handleRulesCommand(doc);
+    }
+}
+
+// ------------------ MQTT 브로커 연결 확인 태스크 ------------------
+void brokerProbeLoop(void* arg) {
+    WiFiClient probe;
+    for (;;) {
+        // reconnect()의 요청을 기다렸다가 브로커 포트에 TCP 연결만 시도 (여기서는 오래 막혀도 loop에 영향 없음)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        bool reachable = probe.connect(mqtt_server, mqtt_port);
+        probe.stop();
+        brokerReachable = reachable;
+        brokerProbeDone = true;
     }
 }
 
 // ------------------ MQTT 재연결 함수 ------------------
 void reconnect() {
-    // MQTT 브로커에 연결될 때까지 시도
-    while (!client.connected()) {
+    if (brokerProbePending) {
+        // 연결 확인 결과가 나올 때까지는 바로 반환
+        if (!brokerProbeDone) return;
+        brokerProbePending = false;
+        if (!brokerReachable) {
+            Serial.println("MQTT broker unreachable, try again in 5 seconds");
+            return;
+        }
+
         Serial.print("Attempting MQTT connection...");
         // "ESP32Client" 이름으로 접속 시도
         if (client.connect("ESP32Client")) {
@@ -230,14 +954,25 @@ void reconnect() {
             client.subscribe(mqtt_topic_subscribe_humidifier);
             client.subscribe(mqtt_topic_subscribe_servo);
             client.subscribe(mqtt_topic_subscribe_security_warn);
+            client.subscribe(mqtt_topic_subscribe_security_status);
+            client.subscribe(mqtt_topic_subscribe_rules);
         } else {
             Serial.print("failed, rc=");
             Serial.print(client.state());
             Serial.println(" try again in 5 seconds");
-            // 실패 시 5초 후 재시도
-            delay(5000);
         }
+        return;
     }
+
+    // 재연결은 reconnectInterval마다 한 번만 시도 (브로커가 없어도 로컬 규칙이 계속 동작하도록)
+    unsigned long now = millis();
+    if (lastReconnectAttempt != 0 && now - lastReconnectAttempt < reconnectInterval) {
+        return;
+    }
+    lastReconnectAttempt = now;
+    brokerProbeDone = false;
+    brokerProbePending = true;
+    xTaskNotifyGive(brokerProbeTask);
 }
 
 // ------------------ 초기 설정 함수(Setup) ------------------
@@ -258,12 +993,30 @@ void setup() {
     digitalWrite(HUMIDIFIER_PIN, LOW);
 
     // 서보 모터 초기화 (0도로 문 닫기 상태)
-    myServo.attach(SERVO_PIN);
-    myServo.write(0);
+    myServo.attach(SERVO_PIN, SERVO_MIN_US, SERVO_MAX_US);
+    myServo.write(SERVO_CLOSED_ANGLE);
+
+    // 서보 모션 타이머 시작 (SERVO_TICK_US 주기)
+    esp_timer_create_args_t servoTimerArgs = {};
+    servoTimerArgs.callback = &onServoTimer;
+    servoTimerArgs.name = "servo";
+    esp_timer_create(&servoTimerArgs, &servoTimer);
+    esp_timer_start_periodic(servoTimer, SERVO_TICK_US);
+
+    // 자동화 규칙 불러오기 (NVS)
+    loadRules();
+#ifdef RULES_BENCH
+    runRulesBenchmark();
+#endif
 
     // MQTT 설정
     client.setServer(mqtt_server, mqtt_port);
     client.setCallback(callback);
+    client.setBufferSize(RULES_JSON_MAX + 64); // 규칙 명령 수신용 버퍼 (MQTT 헤더/토픽 여유 포함)
+    // 확인 직후 브로커가 꺼지거나 CONNACK이 늦어도 loop가 오래 멈추지 않도록 대기 한도 축소
+    espClient.setTimeout(mqttConnectTimeoutSec);
+    client.setSocketTimeout(mqttConnectTimeoutSec);
+    xTaskCreate(brokerProbeLoop, "mqttProbe", 4096, NULL, 1, &brokerProbeTask);
 }
 
 // ------------------ 메인 루프 함수(Loop) ------------------
@@ -271,7 +1024,11 @@ void loop() {
     // MQTT 연결 확인 및 재연결 처리
     if (!client.connected()) {
         reconnect();
+    } else {
+        client.loop();   // MQTT 클라이언트 루프
     }
-    client.loop();   // MQTT 클라이언트 루프
-    readDHT22();     // 주기적으로 DHT22 센서 데이터 읽기 및 발행
+    readDHT22();     // 주기적으로 DHT22 센서 데이터 읽기, 발행 및 규칙 평가
+    updateServo();   // 서보 이동 완료 시 상태 발행
+    updateBlink();   // LED 깜빡임 패턴 진행
+    updateEventRules(); // 경보가 멈춘 이벤트 규칙 해제
 }
@@ -1,7 +1,15 @@
 from http.server import BaseHTTPRequestHandler, HTTPServer
 import paho.mqtt.client as mqtt
 import requests
+import calendar
+import csv
+import io
 import json
+import math
+import random
+import sys
+import threading
+import time
 from urllib.parse import urlparse, parse_qs
 
 # ------------------ 서버 및 포트 설정 ------------------
@@ -25,6 +33,8 @@ mqtt_topic_subscribe_security_status = "home/security/status" # 현재 인원수
 mqtt_topic_subscribe_sensor = "home/sensor/data" # 온/습도 센서 데이터 수신 토픽
 mqtt_topic_subscribe_servo = "home/servo/status" # 서보 상태 수신 토픽 (0도/90도 상태)
 mqtt_topic_subscribe_otp = "home/otp" # OTP 수신 토픽
+mqtt_topic_subscribe_lighting_status = "home/lighting/status" # LED 상태 수신 토픽 (제어 노드가 실제 핀 상태 발행)
+mqtt_topic_subscribe_humidifier_status = "home/humidifier/status" # 가습기 상태 수신 토픽
 
 # ------------------ InfluxDB 설정 ------------------
 influxdb_url = "http://172.20.10.2:8086"
@@ -32,27 +42,145 @@ influxdb_token = "7u65tuouGE6xBkac0dt9rLjdMCqVJU6-P3wvHiiUzIkvWB4e_kfvDqyC2H-28k
 influxdb_bucket = "bucket01"
 influxdb_org = "iotlab"
 
-# ------------------ 전역 변수 (상태 저장) ------------------
-# 센서 데이터 (온도, 습도)
-sensor_data = {
-    "temperature": "--",
-    "humidity": "--"
-}
+influxdb_timeout = 10  # InfluxDB HTTP 요청 타임아웃(초)
+
+# 보존 기간(초), 0이면 무기한, None이면 기존 설정 유지
+influxdb_raw_retention = None  # 원본 버킷 보존 기간은 기본적으로 변경하지 않음
+# --shorten-raw-retention 실행 시에만 롤업 백필 후 원본 버킷을 이 기간으로 줄임
+influxdb_raw_retention_short = 7 * 24 * 3600
+if "--shorten-raw-retention" in sys.argv:
+    influxdb_raw_retention = influxdb_raw_retention_short
 
-# 보안 데이터 (현재 인원수, 최대 인원수)
-security_data = {
-    "people_count": "--",
-    "max_people_allowed": "--"    
+# 롤업 버킷: 이름 -> (윈도우 크기(초), 보존 기간(초))
+influxdb_rollup_buckets = {
+    f"{influxdb_bucket}_1m": (60, 90 * 24 * 3600),  # 1분 롤업, 90일 보관
+    f"{influxdb_bucket}_1h": (3600, 0),             # 1시간 롤업, 무기한
 }
 
-# 조명 상태 (Room1 ~ Room5)
-lighting_status = {f"room{room}": "off" for room in range(1, 6)}
+# 최대값과 함께 최대값 도달 시각(<field>_peak_at)도 기록할 필드 (재실 인원 피크)
+rollup_peak_fields = {"security": ("people_count",)}
+rollup_flush_interval = 10  # 끝난 윈도우를 확인해 기록하는 주기(초)
+
+# ------------------ 상태 저장소 ------------------
+class StateStore:
+    # MQTT 네트워크 스레드(쓰기)와 HTTP 핸들러(읽기)가 공유하는 상태를 lock으로 보호
+    # 키마다 단조 증가하는 버전과 미리 직렬화한 JSON을 보관해 폴링마다 다시 직렬화하지 않는다.
+    def __init__(self, initial, private=()):
+        self._lock = threading.Lock()
+        self._private = set(private)  # /state 응답에서 제외할 키 (OTP 등)
+        self._version = 0       # 전체 저장소 버전 (갱신마다 1씩 증가)
+        self._values = {}       # key -> 값
+        self._versions = {}     # key -> 마지막으로 바뀐 버전
+        self._snapshots = {}    # key -> 직렬화된 JSON(bytes)
+        for key, value in initial.items():
+            self.set(key, value)
+
+    def _set_locked(self, key, value):
+        # lock을 잡은 상태에서 호출: 값이 실제로 바뀐 경우에만 버전 증가
+        body = json.dumps(value).encode('utf-8')
+        if self._snapshots.get(key) == body:
+            return self._versions[key]
+        self._version += 1
+        self._values[key] = json.loads(body)  # 호출자 객체와 분리된 복사본 보관
+        self._versions[key] = self._version
+        self._snapshots[key] = body
+        return self._version
+
+    def set(self, key, value):
+        # 값 교체, 현재 버전 반환
+        with self._lock:
+            return self._set_locked(key, value)
+
+    def update(self, key, **fields):
+        # dict 값의 일부 필드만 갱신
+        with self._lock:
+            value = dict(self._values.get(key) or {})
+            value.update(fields)
+            return self._set_locked(key, value)
+
+    def get(self, key):
+        with self._lock:
+            return json.loads(self._snapshots[key])
+
+    def snapshot(self, key):
+        # (버전, 직렬화된 JSON) 반환
+        with self._lock:
+            return self._versions[key], self._snapshots[key]
+
+    def since(self, version):
+        # version 이후 바뀐 키만 모은 델타 응답을 캐시된 스냅샷으로 조립
+        # (현재 버전, 델타 JSON, 전체 상태 JSON 크기) 반환
+        with self._lock:
+            current = self._version
+            items = [(key, self._snapshots[key], v > version)
+                     for key, v in self._versions.items() if key not in self._private]
+        head = b'{"version": %d, "changes": {' % current
+        parts = [json.dumps(key).encode('utf-8') + b": " + body for key, body, _ in items]
+        changed = [part for part, (_, _, is_changed) in zip(parts, items) if is_changed]
+        full_size = len(head) + len(b", ".join(parts)) + 2
+        return current, head + b", ".join(changed) + b"}}", full_size
 
-# 가습기 상태
-humidifier_status = "off"
+state = StateStore({
+    # 센서 데이터 (온도, 습도)
+    "sensor": {"temperature": "--", "humidity": "--"},
+    # 보안 데이터 (현재 인원수, 최대 인원수)
+    "security": {"people_count": "--", "max_people_allowed": "--"},
+    # 조명 상태 (Room1 ~ Room5)
+    "lighting": {f"room{room}": "off" for room in range(1, 6)},
+    # 가습기 상태
+    "humidifier": "off",
+    # 서보(문) 상태
+    "servo": {"status": "--"},
+    # OTP 데이터 (수신한 OTP)
+    "otp": None,
+}, private=("otp",))
 
-# OTP 데이터
-otp_data = None  # 수신한 OTP를 저장
+# ------------------ 응답 통계 ------------------
+class ResponseStats:
+    # 대시보드 폴링 부하에서 304/델타 응답으로 절약한 전송량과 핸들러 CPU 시간 집계
+    def __init__(self):
+        self._lock = threading.Lock()
+        self.requests = 0
+        self.not_modified = 0
+        self.bytes_sent = 0
+        self.bytes_saved = 0
+        self.cpu_seconds = 0.0
+
+    def record(self, sent, saved, cpu_seconds, not_modified=False):
+        with self._lock:
+            self.requests += 1
+            self.not_modified += 1 if not_modified else 0
+            self.bytes_sent += sent
+            self.bytes_saved += saved
+            self.cpu_seconds += cpu_seconds
+
+    def as_dict(self):
+        with self._lock:
+            return {
+                "requests": self.requests,
+                "not_modified": self.not_modified,
+                "bytes_sent": self.bytes_sent,
+                "bytes_saved": self.bytes_saved,
+                "cpu_ms": round(self.cpu_seconds * 1000, 3),
+                "cpu_ms_per_request": round(self.cpu_seconds * 1000 / self.requests, 4) if self.requests else 0,
+            }
+
+response_stats = ResponseStats()
+
+# 프로세스마다 다른 ETag 접두어: 재시작 후 버전 번호가 다시 1부터 시작해도 이전 실행의 ETag와 겹치지 않게 함
+boot_id = f"{int(time.time() * 1000):x}"
+
+def etag_matches(header, etag):
+    # If-None-Match 비교: 쉼표로 구분된 목록, 약한 비교(W/ 무시), "*" 지원
+    if not header:
+        return False
+    for candidate in header.split(","):
+        candidate = candidate.strip()
+        if candidate.startswith("W/"):
+            candidate = candidate[2:]
+        if candidate == "*" or candidate == etag:
+            return True
+    return False
 
 # ------------------ MQTT 콜백 함수 정의 ------------------
 def on_connect(client, userdata, flags, rc):
@@ -63,67 +191,427 @@ def on_connect(client, userdata, flags, rc):
         (mqtt_topic_subscribe_servo, 0),
         (mqtt_topic_subscribe_otp, 0),
         (mqtt_topic_subscribe_security_warn, 0),
-        (mqtt_topic_subscribe_security_status, 0)
+        (mqtt_topic_subscribe_security_status, 0),
+        (mqtt_topic_subscribe_lighting_status, 0),
+        (mqtt_topic_subscribe_humidifier_status, 0)
     ])
 def on_message(client, userdata, msg):
     # MQTT 메시지 수신 시 처리
-    global sensor_data, otp_data, lighting_status, humidifier_status, security_data
     payload = msg.payload.decode('utf-8')
     topic = msg.topic
     print(f"Received message: {payload} from topic: {topic}")
 
     if topic == mqtt_topic_subscribe_sensor:
-        # 센서 데이터 수신 -> sensor_data 갱신 및 InfluxDB 저장
+        # 센서 데이터 수신 -> 상태 저장소 갱신 및 InfluxDB 저장
         try:
             data = json.loads(payload)
-            sensor_data["temperature"] = data.get("temperature", "--")
-            sensor_data["humidity"] = data.get("humidity", "--")
-            send_to_influxdb("ambient", sensor_data)
+            state.update("sensor",
+                         temperature=data.get("temperature", "--"),
+                         humidity=data.get("humidity", "--"))
+            send_to_influxdb("ambient", state.get("sensor"))
         except json.JSONDecodeError:
             print("Failed to parse sensor data JSON")
 
     elif topic == mqtt_topic_subscribe_otp:
-        # OTP 데이터 수신 -> otp_data 갱신
+        # OTP 데이터 수신 -> 상태 저장소 갱신
         try:
             data = json.loads(payload)
-            otp_data = str(data.get("otp", "--"))
-            print(f"OTP received: {otp_data}")
+            otp = str(data.get("otp", "--"))
+            state.set("otp", otp)
+            print(f"OTP received: {otp}")
         except json.JSONDecodeError:
             print("Failed to parse OTP JSON")
 
+    elif topic == mqtt_topic_subscribe_servo:
+        # 서보 상태 수신 (moving / open / closed) -> 상태 저장소 갱신
+        try:
+            state.set("servo", json.loads(payload))
+        except json.JSONDecodeError:
+            print("Failed to parse servo status JSON")
+
+    elif topic == mqtt_topic_subscribe_lighting_status:
+        # LED 상태 수신 ({"led": n, "status": ...} 또는 전체 {"status": ...}) -> 상태 저장소 갱신
+        try:
+            data = json.loads(payload)
+            status = data.get("status")
+            rooms = state.get("lighting")
+            if status in ("on", "off"):
+                if "led" not in data:
+                    state.update("lighting", **{room: status for room in rooms})
+                elif f"room{data['led']}" in rooms:
+                    state.update("lighting", **{f"room{data['led']}": status})
+        except json.JSONDecodeError:
+            print("Failed to parse lighting status JSON")
+
+    elif topic == mqtt_topic_subscribe_humidifier_status:
+        # 가습기 상태 수신 (수동 명령이나 자동화 규칙으로 바뀐 실제 상태) -> 상태 저장소 갱신
+        try:
+            status = json.loads(payload).get("status")
+            if status in ("on", "off"):
+                state.set("humidifier", status)
+        except json.JSONDecodeError:
+            print("Failed to parse humidifier status JSON")
+
     elif topic == mqtt_topic_subscribe_security_warn:
         # 경고 메시지 수신 시 LED 점멸 명령 발행
         mqtt_client.publish(mqtt_topic_publish_lighting, json.dumps({"command": "blink"}))
         print("Warning received! Sending LED alert command.")
 
     elif topic == mqtt_topic_subscribe_security_status:
-        # 현재 인원수 상태 수신 -> security_data 갱신 및 InfluxDB 저장
+        # 현재 인원수 상태 수신 -> 상태 저장소 갱신 및 InfluxDB 저장
         try:
             data1 = json.loads(payload)
-            security_data["people_count"] = data1.get("people_count", "--")
-            security_data["max_people_allowed"] = data1.get("max_people_allowed", "--")
-            send_to_influxdb("security", security_data)
+            state.update("security",
+                         people_count=data1.get("people_count", "--"),
+                         max_people_allowed=data1.get("max_people_allowed", "--"))
+            send_to_influxdb("security", state.get("security"))
         except json.JSONDecodeError:
             print("Failed to parse security status JSON")
 
-def send_to_influxdb(measurement, fields):
-    # InfluxDB로 데이터 전송
-    url = f"{influxdb_url}/api/v2/write?bucket={influxdb_bucket}&org={influxdb_org}&precision=s"
-    headers = {
+def influxdb_headers(content_type="text/plain"):
+    return {
         "Authorization": f"Token {influxdb_token}",
-        "Content-Type": "text/plain"
+        "Content-Type": content_type
     }
+
+def to_line(measurement, fields, timestamp):
+    # InfluxDB line protocol 한 줄 생성, 기록할 필드가 없으면 None
     field_set = ",".join([f"{key}={value}" for key, value in fields.items() if value != "--"])
-    data = f"{measurement} {field_set}"
+    if not field_set:
+        return None
+    return f"{measurement} {field_set} {timestamp}"
+
+def write_lines(bucket, lines):
+    # 여러 줄을 한 번의 요청으로 기록
+    if not lines:
+        return
+    url = f"{influxdb_url}/api/v2/write?bucket={bucket}&org={influxdb_org}&precision=s"
     try:
-        response = requests.post(url, headers=headers, data=data)
+        response = requests.post(url, headers=influxdb_headers(), data="\n".join(lines),
+                                 timeout=influxdb_timeout)
         if response.status_code == 204:
-            print("Data written to InfluxDB successfully.")
+            print(f"Data written to InfluxDB successfully. ({bucket}, {len(lines)} lines)")
         else:
             print(f"Failed to write to InfluxDB: {response.status_code} {response.text}")
     except Exception as e:
         print(f"Error sending data to InfluxDB: {str(e)}")
 
+def find_bucket(name):
+    # 이름으로 버킷 조회, 없으면 None (요청 실패 시 예외)
+    response = requests.get(f"{influxdb_url}/api/v2/buckets", headers=influxdb_headers(),
+                            params={"org": influxdb_org, "name": name}, timeout=influxdb_timeout)
+    if response.status_code == 404:
+        return None
+    response.raise_for_status()
+    buckets = response.json().get("buckets", [])
+    return buckets[0] if buckets else None
+
+def bucket_retention(bucket):
+    # 버킷의 보존 기간(초), 0이면 무기한
+    for rule in bucket.get("retentionRules", []):
+        if rule.get("type") == "expire":
+            return rule.get("everySeconds", 0)
+    return 0
+
+def ensure_bucket(name, retention_seconds):
+    # 버킷이 없으면 만들고, 있으면 보존 기간만 맞춘다
+    if retention_seconds is None:
+        return
+    rules = [{"type": "expire", "everySeconds": retention_seconds}] if retention_seconds else []
+    try:
+        bucket = find_bucket(name)
+        if bucket is not None:
+            response = requests.patch(f"{influxdb_url}/api/v2/buckets/{bucket['id']}",
+                                      headers=influxdb_headers("application/json"),
+                                      json={"retentionRules": rules}, timeout=influxdb_timeout)
+        else:
+            orgs = requests.get(f"{influxdb_url}/api/v2/orgs", headers=influxdb_headers(),
+                                params={"org": influxdb_org}, timeout=influxdb_timeout).json()["orgs"]
+            response = requests.post(f"{influxdb_url}/api/v2/buckets",
+                                     headers=influxdb_headers("application/json"),
+                                     json={"orgID": orgs[0]["id"], "name": name, "retentionRules": rules},
+                                     timeout=influxdb_timeout)
+        if response.status_code in (200, 201):
+            retention = f"{retention_seconds}s" if retention_seconds else "infinite"
+            print(f"InfluxDB bucket ready: {name} (retention {retention})")
+        else:
+            print(f"Failed to configure bucket {name}: {response.status_code} {response.text}")
+    except Exception as e:
+        print(f"Error configuring InfluxDB bucket {name}: {str(e)}")
+
+def delete_bucket(name):
+    try:
+        bucket = find_bucket(name)
+        if bucket is not None:
+            requests.delete(f"{influxdb_url}/api/v2/buckets/{bucket['id']}", headers=influxdb_headers(),
+                            timeout=influxdb_timeout).raise_for_status()
+            print(f"InfluxDB bucket deleted: {name}")
+    except Exception as e:
+        print(f"Error deleting InfluxDB bucket {name}: {str(e)}")
+
+def run_flux(query, timeout=influxdb_timeout):
+    headers = influxdb_headers("application/vnd.flux")
+    headers["Accept"] = "application/csv"
+    return requests.post(f"{influxdb_url}/api/v2/query?org={influxdb_org}", headers=headers,
+                         data=query, timeout=timeout)
+
+def backfill_rollups(stop):
+    # 원본 버킷에 남아 있는 데이터로 롤업 버킷을 채움 (원본 보존 기간을 줄이기 전에 한 번 실행)
+    # stop 이후의 윈도우는 실시간 집계가 기록하므로 제외, peak_at은 원본에서 복원하지 않음
+    for bucket, (size, retention) in influxdb_rollup_buckets.items():
+        start = f"-{retention}s" if retention else "0"
+        window_stop = stop - stop % size
+        for fn in ("min", "max", "mean", "count"):
+            query = f'''import "types"
+from(bucket: "{influxdb_bucket}") |> range(start: {start}, stop: {window_stop})
+    |> filter(fn: (r) => types.isType(v: r._value, type: "float") or types.isType(v: r._value, type: "int"))
+    |> aggregateWindow(every: {size}s, fn: {fn}, timeSrc: "_start", createEmpty: false)
+    |> map(fn: (r) => ({{r with _field: r._field + "_{fn}"}}))
+    |> to(bucket: "{bucket}", org: "{influxdb_org}")'''
+            try:
+                response = run_flux(query, timeout=600)
+            except Exception as e:
+                print(f"Error backfilling {bucket} ({fn}): {str(e)}")
+                return False
+            if response.status_code != 200:
+                print(f"Failed to backfill {bucket} ({fn}): {response.status_code} {response.text}")
+                return False
+        print(f"Rollup bucket backfilled from raw data: {bucket}")
+    return True
+
+def configure_buckets():
+    # 롤업 버킷을 먼저 만들고, 원본 보존 기간을 줄일 때는 기존 원본으로 롤업을 채운 뒤에만 줄임
+    for bucket, (_, retention) in influxdb_rollup_buckets.items():
+        ensure_bucket(bucket, retention)
+    if influxdb_raw_retention is None:
+        return
+    if influxdb_raw_retention:
+        try:
+            raw = find_bucket(influxdb_bucket)
+        except Exception as e:
+            print(f"Error reading InfluxDB bucket {influxdb_bucket}: {str(e)}")
+            return
+        current = bucket_retention(raw) if raw is not None else None
+        if current is not None and 0 < current <= influxdb_raw_retention:
+            # 이미 같거나 더 짧으면 그대로 둠 (늘리지 않음)
+            print(f"Retention of {influxdb_bucket} already {current}s, not changed")
+            return
+        if current is not None and not backfill_rollups(int(time.time())):
+            print(f"Keeping retention of {influxdb_bucket} unchanged")
+            return
+    ensure_bucket(influxdb_bucket, influxdb_raw_retention)
+
+# ------------------ 롤업 집계 ------------------
+class RollupAggregator:
+    # measurement별 텀블링 윈도우(1분/1시간)로 min/max/mean/count를 집계해 롤업 버킷에 기록
+    # MQTT 스레드(add)와 flush 스레드(flush_expired)가 함께 쓰므로 lock으로 보호
+    def __init__(self, windows, writer, peak_fields=None):
+        self._lock = threading.Lock()
+        self._windows = windows            # 버킷 이름 -> 윈도우 크기(초)
+        self._writer = writer              # writer(bucket, lines)
+        self._peak_fields = peak_fields or {}
+        self._open = {}                    # (버킷, measurement) -> [윈도우 시작, {필드: [min, max, sum, count, peak_at]}]
+        self._closed = {}                  # (버킷, measurement) -> 마지막으로 기록한 윈도우 시작
+        self.dropped = 0                   # 이미 기록한 윈도우에 늦게 도착해 버린 샘플 수
+
+    def add(self, measurement, fields, timestamp):
+        values = {}
+        for key, value in fields.items():
+            try:
+                values[key] = float(value)
+            except (TypeError, ValueError):
+                pass  # "--" 등 숫자가 아닌 값은 집계하지 않음
+        if not values:
+            return
+        closed = []
+        with self._lock:
+            for bucket, size in self._windows.items():
+                start = timestamp - timestamp % size
+                key = (bucket, measurement)
+                window = self._open.get(key)
+                if start <= self._closed.get(key, -1) or (window is not None and start < window[0]):
+                    # 이미 기록한 윈도우의 샘플: 다시 열면 같은 시각에 부분 집계가 덮어쓰므로 버림
+                    self.dropped += 1
+                    continue
+                if window is not None and start > window[0]:
+                    # 새 윈도우 시작: 이전 윈도우를 닫음
+                    closed.append((bucket, self._to_line(measurement, window)))
+                    self._closed[key] = window[0]
+                    window = None
+                if window is None:
+                    window = self._open[key] = [start, {}]
+                for field, value in values.items():
+                    stats = window[1].get(field)
+                    if stats is None:
+                        window[1][field] = [value, value, value, 1, timestamp]
+                        continue
+                    if value > stats[1]:
+                        stats[1] = value
+                        stats[4] = timestamp
+                    stats[0] = min(stats[0], value)
+                    stats[2] += value
+                    stats[3] += 1
+        self._write(closed)
+
+    def flush_expired(self, now):
+        # 끝난 윈도우는 다음 샘플을 기다리지 않고 기록
+        self._flush(lambda start, size: start + size <= now)
+
+    def flush_all(self):
+        self._flush(lambda start, size: True)
+
+    def _flush(self, should_close):
+        closed = []
+        with self._lock:
+            for (bucket, measurement), window in list(self._open.items()):
+                if should_close(window[0], self._windows[bucket]):
+                    closed.append((bucket, self._to_line(measurement, window)))
+                    self._closed[(bucket, measurement)] = window[0]
+                    del self._open[(bucket, measurement)]
+        self._write(closed)
+
+    def _write(self, closed):
+        # 버킷별로 묶어서 한 번에 기록
+        by_bucket = {}
+        for bucket, line in closed:
+            by_bucket.setdefault(bucket, []).append(line)
+        for bucket, lines in by_bucket.items():
+            self._writer(bucket, lines)
+
+    def _to_line(self, measurement, window):
+        start, stats = window
+        fields = {}
+        for field, (low, high, total, count, peak_at) in stats.items():
+            fields[f"{field}_min"] = low
+            fields[f"{field}_max"] = high
+            fields[f"{field}_mean"] = round(total / count, 4)
+            fields[f"{field}_count"] = f"{count}i"
+            if field in self._peak_fields.get(measurement, ()):
+                fields[f"{field}_peak_at"] = f"{peak_at}i"
+        return to_line(measurement, fields, start)
+
+def send_to_influxdb(measurement, fields):
+    # 원본 샘플을 서버 수신 시각과 함께 기록하고 롤업 집계에 반영
+    # 롤업에 먼저 반영: 원본 기록이 타임아웃까지 막히는 동안 flush 스레드가 윈도우를 닫지 않도록
+    timestamp = int(time.time())
+    line = to_line(measurement, fields, timestamp)
+    if line is None:
+        return
+    rollup.add(measurement, fields, timestamp)
+    write_lines(influxdb_bucket, [line])
+
+rollup = RollupAggregator({bucket: size for bucket, (size, _) in influxdb_rollup_buckets.items()},
+                          write_lines, rollup_peak_fields)
+
+def restore_open_windows(now):
+    # 재시작 시 진행 중이던 1분/1시간 윈도우를 원본 버킷으로 다시 채움
+    # (빈 상태로 시작하면 이전 실행이 종료 시 기록한 부분 집계를 나머지 절반이 덮어씀)
+    start = min(now - now % size for size, _ in influxdb_rollup_buckets.values())
+    query = f'''import "types"
+from(bucket: "{influxdb_bucket}") |> range(start: {start}, stop: {now})
+    |> filter(fn: (r) => types.isType(v: r._value, type: "float") or types.isType(v: r._value, type: "int"))
+    |> keep(columns: ["_time", "_measurement", "_field", "_value"])'''
+    try:
+        response = run_flux(query)
+    except Exception as e:
+        print(f"Error restoring rollup windows: {str(e)}")
+        return
+    if response.status_code != 200:
+        print(f"Failed to restore rollup windows: {response.status_code} {response.text}")
+        return
+    samples = {}  # (시각, measurement) -> {필드: 값}
+    header = None
+    for row in csv.reader(io.StringIO(response.text)):
+        if not row or row[0].startswith("#"):
+            header = None if not row else header
+            continue
+        if header is None:
+            header = row
+            continue
+        record = dict(zip(header, row))
+        ts = calendar.timegm(time.strptime(record["_time"][:19], "%Y-%m-%dT%H:%M:%S"))
+        samples.setdefault((ts, record["_measurement"]), {})[record["_field"]] = record["_value"]
+    for (ts, measurement), fields in sorted(samples.items()):
+        rollup.add(measurement, fields, ts)
+    print(f"Restored open rollup windows from {len(samples)} raw samples")
+
+def rollup_flush_loop():
+    while True:
+        time.sleep(rollup_flush_interval)
+        rollup.flush_expired(int(time.time()))
+
+# ------------------ 롤업 벤치마크 ------------------
+def run_rollup_benchmark(days=30, interval=2):
+    # 30일치 ambient 샘플(2초 간격)을 생성해 원본/1시간 롤업 버킷에 기록한 뒤
+    # 30일 대시보드 쿼리(시간별 평균 습도) 시간을 비교
+    raw_bucket = f"{influxdb_bucket}_bench_raw"
+    hour_bucket = f"{influxdb_bucket}_bench_1h"
+    # 30일 전 시각의 샘플을 기록해야 하므로 무기한으로 만들고 벤치마크 후 삭제
+    for bucket in (raw_bucket, hour_bucket):
+        ensure_bucket(bucket, 0)
+    try:
+        _run_rollup_benchmark(raw_bucket, hour_bucket, days, interval)
+    finally:
+        for bucket in (raw_bucket, hour_bucket):
+            delete_bucket(bucket)
+
+def _run_rollup_benchmark(raw_bucket, hour_bucket, days, interval):
+
+    pending = {}
+    def collect(bucket, lines):
+        pending.setdefault(bucket, []).extend(lines)
+    bench = RollupAggregator({hour_bucket: 3600}, collect)
+
+    rng = random.Random(0)
+    end = int(time.time())
+    raw_lines = []
+    print(f"Generating {days * 86400 // interval} samples...")
+    for ts in range(end - days * 86400, end, interval):
+        day = math.sin(2 * math.pi * ts / 86400)
+        fields = {
+            "temperature": f"{24 + 3 * day + rng.gauss(0, 0.2):.2f}",
+            "humidity": f"{50 - 10 * day + rng.gauss(0, 1):.2f}",
+        }
+        raw_lines.append(to_line("ambient", fields, ts))
+        bench.add("ambient", fields, ts)
+        if len(raw_lines) >= 5000:
+            write_lines(raw_bucket, raw_lines)
+            raw_lines = []
+    write_lines(raw_bucket, raw_lines)
+    bench.flush_all()
+    write_lines(hour_bucket, pending.get(hour_bucket, []))
+    print(f"humidity points scanned: raw {days * 86400 // interval}, "
+          f"rollup_1h {len(pending.get(hour_bucket, []))}")
+
+    queries = {
+        "raw": f'''from(bucket: "{raw_bucket}") |> range(start: -{days}d)
+            |> filter(fn: (r) => r._measurement == "ambient" and r._field == "humidity")
+            |> aggregateWindow(every: 1h, fn: mean, createEmpty: false)''',
+        "rollup_1h": f'''from(bucket: "{hour_bucket}") |> range(start: -{days}d)
+            |> filter(fn: (r) => r._measurement == "ambient" and r._field == "humidity_mean")''',
+    }
+    medians = {}
+    for name, query in queries.items():
+        timings = []
+        for _ in range(5):
+            started = time.perf_counter()
+            response = run_flux(query, timeout=120)
+            timings.append(time.perf_counter() - started)
+        timings.sort()
+        print(f"{name}: status {response.status_code}, {len(response.content)} bytes, "
+              f"min {timings[0] * 1000:.1f} ms, median {timings[2] * 1000:.1f} ms")
+        medians[name] = timings[2]
+    print(f"{days}-day query speedup (median): {medians['raw'] / max(medians['rollup_1h'], 1e-9):.1f}x")
+
+if "--rollup-bench" in sys.argv:
+    run_rollup_benchmark()
+    sys.exit(0)
+
+# 버킷 보존 기간 설정, 진행 중인 롤업 윈도우 복원 및 flush 스레드 시작
+configure_buckets()
+restore_open_windows(int(time.time()))
+threading.Thread(target=rollup_flush_loop, daemon=True).start()
+
 # MQTT 클라이언트 생성 및 이벤트 함수 할당
 mqtt_client = mqtt.Client()
 mqtt_client.on_connect = on_connect
@@ -133,6 +621,26 @@ mqtt_client.loop_start()
 
 # ------------------ HTTP 서버 핸들러 정의 ------------------
 class MyServer(BaseHTTPRequestHandler):
+    def send_json_snapshot(self, etag, body, started, full_size=None):
+        # 캐시된 JSON 스냅샷 응답, If-None-Match가 현재 ETag와 같으면 본문 없이 304
+        if etag_matches(self.headers.get('If-None-Match'), etag):
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.end_headers()
+            response_stats.record(0, len(body), time.thread_time() - started, not_modified=True)
+            return
+        self.send_response(200)
+        self.send_header('Content-type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.send_header('ETag', etag)
+        # 브라우저가 매 폴링마다 If-None-Match로 재검증하도록 설정
+        self.send_header('Cache-Control', 'no-cache')
+        self.end_headers()
+        self.wfile.write(body)
+        # 델타 응답은 전체 상태 대비 줄어든 크기를 절약량으로 집계
+        saved = full_size - len(body) if full_size is not None else 0
+        response_stats.record(len(body), saved, time.thread_time() - started)
+
     def do_GET(self):
         # 기본 페이지 ("/"): OTP 입력 페이지
         if self.path == "/":
@@ -180,7 +688,7 @@ class MyServer(BaseHTTPRequestHandler):
             otp_message = ""
             if "otp" in params:
                 entered_otp = params["otp"][0]
-                if str(entered_otp) == str(otp_data):
+                if str(entered_otp) == str(state.get("otp")):
                     # OTP 성공 시, 서보 모터를 통해 문 열기 명령
                     print("OTP verified successfully!")
                     mqtt_client.publish(mqtt_topic_publish_servo, json.dumps({"command": "on"}))
@@ -234,6 +742,7 @@ class MyServer(BaseHTTPRequestHandler):
             self.send_response(200)
             self.send_header('Content-type', 'text/html')
             self.end_headers()
+            sensor_data = state.get("sensor")
             html = f"""
             <html>
             <head>
@@ -398,12 +907,33 @@ class MyServer(BaseHTTPRequestHandler):
             self.end_headers()
             self.wfile.write(bytes('{"status":"ok"}', 'utf-8'))
 
-        # "/sensor": 현재 센서 데이터 반환
+        # "/sensor": 현재 센서 데이터 반환 (ETag / 304 지원)
         elif self.path.startswith("/sensor"):
+            started = time.thread_time()
+            version, body = state.snapshot("sensor")
+            self.send_json_snapshot(f'"{boot_id}-sensor-{version}"', body, started)
+
+        # "/state": 전체 상태 반환, "?since=<version>"이면 해당 버전 이후 바뀐 키만 반환
+        elif self.path.startswith("/state"):
+            started = time.thread_time()
+            params = parse_qs(urlparse(self.path).query)
+            try:
+                since = int(params["since"][0]) if "since" in params else 0
+            except ValueError:
+                self.send_response(400)
+                self.send_header('Content-type', 'application/json')
+                self.end_headers()
+                self.wfile.write(bytes('{"status":"error","message":"invalid since"}', 'utf-8'))
+                return
+            version, body, full_size = state.since(since)
+            self.send_json_snapshot(f'"{boot_id}-state-{since}-{version}"', body, started, full_size)
+
+        # "/stats": 폴링 응답 통계 (304 비율, 절약한 바이트, 핸들러 CPU 시간)
+        elif self.path.startswith("/stats"):
             self.send_response(200)
             self.send_header('Content-type', 'application/json')
             self.end_headers()
-            self.wfile.write(bytes(json.dumps(sensor_data), 'utf-8'))
+            self.wfile.write(bytes(json.dumps(response_stats.as_dict()), 'utf-8'))
 
         else:
             # 정의되지 않은 경로 요청 시 404 반환
@@ -421,4 +951,5 @@ except KeyboardInterrupt:
     pass
 
 webServer.server_close()
+rollup.flush_all()  # 진행 중인 윈도우도 종료 전에 기록
 print('Server stopped')